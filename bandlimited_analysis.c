@@ -0,0 +1,430 @@
+/**
+
+
+Apache License 2.0
+
+bandlimited~
+    Copyright [2010] Paulo Casaes
+
+      This product includes software developed at
+      Github (https://github.com/pcasaes/bandlimited).
+
+ --
+ https://github.com/pcasaes/bandlimited
+ mailto:pcasaes@gmail.com
+
+ v 0.93
+ */
+
+/*
+ * Offline quality against cost analysis of the oscillator core, see make
+ * analysis. Every waveform is rendered in every mode, with a few cutoffs
+ * and maximum harmonics, over a grid of frequencies. Each rendering is
+ * FFT'd and compared with ideal additive synthesis, every harmonic below
+ * nyquist at its exact amplitude and phase:
+ *
+ *	alias			energy outside the harmonics, dB below the ideal signal
+ *	harmonic error	energy of the difference on the harmonics, dB below the
+ *					ideal signal. Harmonics left out by the cutoff or the
+ *					maximum count as error.
+ *
+ * Frequencies sit on odd FFT bins, so the harmonics land on bins exactly
+ * and, the FFT size being a power of 2, no alias lands on a harmonic. Every
+ * row is written to a CSV file along with its CPU cost, and a plain text
+ * summary per waveform marks the settings no other setting beats on both
+ * cost and error.
+ *
+ * Before that every waveform's crossfade is swept through the whole range
+ * of harmonics and checked for steps, see bandlimited_analysis_sweep. A
+ * step fails the analysis.
+ *
+ * usage: bandlimited_analysis [-o report.csv] [-t ms per run] [-r sample rate] [-s table size] [wave ...]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bandlimited_core.h"
+#include "bandlimited_util.h"
+
+#define BANDLIMITED_ANALYSIS_SIZE 65536			// FFT size, a power of 2
+#define BANDLIMITED_ANALYSIS_BLOCK 64
+#define BANDLIMITED_ANALYSIS_RUNS 3
+#define BANDLIMITED_ANALYSIS_DUTY 0.25f			// pulse width, 0.5 would be a square
+#define BANDLIMITED_ANALYSIS_FLOOR -200.0			// dB reported for no energy at all
+#define BANDLIMITED_ANALYSIS_MAXSETTINGS 32
+#define BANDLIMITED_ANALYSIS_SWEEP 262144			// samples of the sweep check
+#define BANDLIMITED_ANALYSIS_NUDGE 1e-4f			// how much higher the twin's cutoff is
+#define BANDLIMITED_ANALYSIS_JUMP 1e-3				// most the twins may differ by
+
+static const char *bandlimited_wavenames[] = {"saw", "rsaw", "square", "triangle", "sawtriangle", "pulse"};
+static const char *bandlimited_modenames[] = {"exact", "approximate", "crossfade"};
+static const float bandlimited_analysis_cutoffs[] = {1.0f, 0.8f, 0.6f};		// of nyquist
+static const unsigned int bandlimited_analysis_max[] = {BANDLIMITED_MAXHARMONICS, 128};
+
+static float bandlimited_analysis_in[BANDLIMITED_ANALYSIS_SIZE];
+static float bandlimited_analysis_dc[BANDLIMITED_ANALYSIS_SIZE];
+static float bandlimited_analysis_out[BANDLIMITED_ANALYSIS_SIZE];
+static double bandlimited_analysis_re[BANDLIMITED_ANALYSIS_SIZE];
+static double bandlimited_analysis_im[BANDLIMITED_ANALYSIS_SIZE];
+static double bandlimited_analysis_twiddles[BANDLIMITED_ANALYSIS_SIZE];
+static double bandlimited_analysis_runtime = 0.01;
+static float bandlimited_analysis_sr = 44100.0f;
+static int bandlimited_analysis_tabsize = 0;
+
+typedef struct _bandlimited_setting
+	{
+		t_bandlimited_mode mode;
+		float cutoff;
+		unsigned int max;
+		int rows;
+		double ns;
+		double alias;
+		double worstalias;
+		double error;
+	} t_bandlimited_setting;
+
+/*
+ * This function gives the ideal harmonic k of a waveform, the way the
+ * oscillator renders it from phase 0: a cos(2 pi k p) + b sin(2 pi k p).
+ * The DC of the pulse is left out, like the analysis leaves DC out.
+ *
+ * param t_bandlimited_wave waveform type
+ * param int harmonic
+ * param double * where a is stored
+ * param double * where b is stored
+ */
+static void bandlimited_analysis_ideal(t_bandlimited_wave wave, int k, double *a, double *b) {
+	double saw = 2.0 / (BANDLIMITED_PI * k);
+	double odd = k % 2 ? 1.0 : 0.0;
+	double w = 2.0 * BANDLIMITED_PI * k * BANDLIMITED_ANALYSIS_DUTY;
+
+	*a = *b = 0.0;
+	switch(wave) {
+		case BANDLIMITED_SAW:
+			*b = -saw;
+			break;
+		case BANDLIMITED_RSAW:
+			*b = saw;
+			break;
+		case BANDLIMITED_SQUARE:
+			*b = odd * 4.0 / (BANDLIMITED_PI * k);
+			break;
+		case BANDLIMITED_TRIANGLE:
+			*b = odd * (k % 4 == 3 ? -8.0 : 8.0) / (BANDLIMITED_PISQ * k * k);
+			break;
+		case BANDLIMITED_SAWTRIANGLE:
+			*b = odd * (k % 4 == 3 ? -8.0 : 8.0) / (BANDLIMITED_PISQ * k * k) - saw;
+			break;
+		case BANDLIMITED_PULSE:
+			// the saw a duty cycle ahead less the saw
+			*a = saw * sin(w);
+			*b = saw * (cos(w) - 1.0);
+			break;
+	}
+}
+
+/*
+ * This function finds the frequency of an FFT bin as the oscillator sees
+ * it, a float whose phase increment is exactly bin / size so the phase
+ * doesn't drift off the bin over the FFT. A few ulps around the bin's
+ * frequency are tried, and when none is exact the next odd bins.
+ *
+ * param int * FFT bin, odd, moved to the bin found
+ *
+ * return float frequency in hz
+ */
+static float bandlimited_analysis_binfreq(int *bin) {
+	float conv = 1.0f / bandlimited_analysis_sr, inc, f, up, down;
+	int b, i;
+
+	for(b = *bin; b < *bin + 64 && b < BANDLIMITED_ANALYSIS_SIZE / 2; b += 2) {
+		inc = (float)b / BANDLIMITED_ANALYSIS_SIZE;
+		f = up = down = (float)b * bandlimited_analysis_sr / BANDLIMITED_ANALYSIS_SIZE;
+		for(i = 0; i < 8; i++) {
+			if(up * conv == inc || down * conv == inc) {
+				*bin = b;
+				return up * conv == inc ? up : down;
+			}
+			up = nextafterf(up, 2.0f * f);
+			down = nextafterf(down, 0.0f);
+		}
+	}
+	return (float)*bin * bandlimited_analysis_sr / BANDLIMITED_ANALYSIS_SIZE;
+}
+
+/*
+ * return double energy in dB, BANDLIMITED_ANALYSIS_FLOOR for none
+ */
+static double bandlimited_analysis_db(double energy) {
+	return energy > 0.0 ? 10.0 * log10(energy) : BANDLIMITED_ANALYSIS_FLOOR;
+}
+
+/*
+ * This function renders one oscillator setting at one frequency, measures
+ * its alias and harmonic error and times it.
+ *
+ * param t_bandlimited_wave waveform type
+ * param t_bandlimited_setting * the setting
+ * param int FFT bin of the frequency, odd
+ * param float frequency of the bin, see bandlimited_analysis_binfreq
+ * param double * where the alias in dB is stored
+ * param double * where the harmonic error in dB is stored
+ *
+ * return double ns per sample of the fastest run
+ */
+static double bandlimited_analysis_run(t_bandlimited_wave wave, t_bandlimited_setting *s, int bin, float f, double *alias, double *error) {
+	const int n = BANDLIMITED_ANALYSIS_SIZE;
+	t_bandlimited_osc x;
+	const float *dc = wave == BANDLIMITED_PULSE ? bandlimited_analysis_dc : 0;
+	double total = 0.0, harmonics = 0.0, diff = 0.0, e, a, b, start, elapsed, best = 0.0;
+	long samples;
+	int i, run;
+
+	for(i = 0; i < n; i++)
+		bandlimited_analysis_in[i] = f;
+	bandlimited_osc_init(&x, wave, s->max, s->cutoff, s->mode);
+	bandlimited_osc_settabsize(&x, bandlimited_analysis_tabsize);
+	bandlimited_osc_setsr(&x, bandlimited_analysis_sr);
+	for(i = 0; i < n; i += BANDLIMITED_ANALYSIS_BLOCK)
+		bandlimited_osc_render(&x, bandlimited_analysis_in + i, dc ? dc + i : 0, bandlimited_analysis_out + i, BANDLIMITED_ANALYSIS_BLOCK);
+
+	// forward FFT as the conjugate of the inverse one
+	for(i = 0; i < n; i++) {
+		bandlimited_analysis_re[i] = bandlimited_analysis_out[i];
+		bandlimited_analysis_im[i] = 0.0;
+	}
+	bandlimited_ifft(bandlimited_analysis_re, bandlimited_analysis_im, bandlimited_analysis_twiddles, n);
+	for(i = 1; i < n / 2; i++) {
+		// power of the sinusoid on bin i
+		e = 2.0 * (bandlimited_analysis_re[i] * bandlimited_analysis_re[i] + bandlimited_analysis_im[i] * bandlimited_analysis_im[i]) / ((double)n * n);
+		if(i % bin) {
+			total += e;
+			continue;
+		}
+		bandlimited_analysis_ideal(wave, i / bin, &a, &b);
+		harmonics += (a * a + b * b) / 2.0;
+		a -= 2.0 * bandlimited_analysis_re[i] / n;
+		b -= 2.0 * bandlimited_analysis_im[i] / n;
+		diff += (a * a + b * b) / 2.0;
+	}
+	*alias = bandlimited_analysis_db(total / harmonics);
+	*error = bandlimited_analysis_db(diff / harmonics);
+
+	for(run = 0; run < BANDLIMITED_ANALYSIS_RUNS; run++) {
+		samples = 0;
+		start = bandlimited_clock();
+		do {
+			for(i = 0; i < n; i += BANDLIMITED_ANALYSIS_BLOCK)
+				bandlimited_osc_render(&x, bandlimited_analysis_in + i, dc ? dc + i : 0, bandlimited_analysis_out + i, BANDLIMITED_ANALYSIS_BLOCK);
+			samples += n;
+			elapsed = bandlimited_clock() - start;
+		} while(elapsed < bandlimited_analysis_runtime);
+		if(run == 0 || elapsed / samples < best)
+			best = elapsed / samples;
+	}
+	return best * 1e9;
+}
+
+/*
+ * This function sweeps a crossfade from below the first harmonic down to
+ * past its maximum, through every whole number of harmonics, every level
+ * and onto the maximum. A twin sweeps along at the same phase with the
+ * cutoff a hair higher: where the waveform changes smoothly with the
+ * number of harmonics the two barely differ, where it steps one of them is
+ * past the step before the other. Only the second of two sweeps counts,
+ * the first builds the wavetables so neither reads a stand in.
+ *
+ * param t_bandlimited_wave waveform type
+ * param float * where the frequency of the worst difference is stored
+ *
+ * return double the worst difference between the twins
+ */
+static double bandlimited_analysis_sweep(t_bandlimited_wave wave, float *at) {
+	const int n = BANDLIMITED_ANALYSIS_SWEEP, block = BANDLIMITED_ANALYSIS_BLOCK;
+	const float *dc = wave == BANDLIMITED_PULSE ? bandlimited_analysis_dc : 0;
+	float out[BANDLIMITED_ANALYSIS_BLOCK], twin[BANDLIMITED_ANALYSIS_BLOCK];
+	float cutoff = 0.8f * bandlimited_analysis_sr / 2.0f;
+	unsigned int max = BANDLIMITED_MAXHARMONICS;
+	t_bandlimited_osc x, y;
+	double worst = 0.0, high, low, d;
+	int i, j, pass;
+
+#if BANDLIMITED_AUDIBLE > 0
+	// the sets of wider bands have no crossfade, see bandlimited_osc_settype
+	if(cutoff > 0.8f * BANDLIMITED_AUDIBLE)
+		cutoff = 0.8f * BANDLIMITED_AUDIBLE;
+#endif
+	// smaller tables stop at fewer harmonics, past them the polyBLEPs take over
+	if(bandlimited_analysis_tabsize < BANDLIMITED_TABSIZE)
+		max = BANDLIMITED_MAXHARMONICS * bandlimited_analysis_tabsize / BANDLIMITED_TABSIZE;
+	bandlimited_osc_init(&x, wave, max, cutoff, BANDLIMITED_CROSSFADE);
+	bandlimited_osc_init(&y, wave, max, cutoff * (1.0f + BANDLIMITED_ANALYSIS_NUDGE), BANDLIMITED_CROSSFADE);
+	bandlimited_osc_settabsize(&x, bandlimited_analysis_tabsize);
+	bandlimited_osc_settabsize(&y, bandlimited_analysis_tabsize);
+	bandlimited_osc_setsr(&x, bandlimited_analysis_sr);
+	bandlimited_osc_setsr(&y, bandlimited_analysis_sr);
+	high = cutoff / 0.9;
+	low = cutoff / (1.1 * max);
+	*at = 0.0f;
+	for(pass = 0; pass < 2; pass++)
+		for(i = 0; i < n; i += block) {
+			for(j = 0; j < block; j++)
+				bandlimited_analysis_in[j] = (float)(high * pow(low / high, (double)(i + j) / n));
+			bandlimited_osc_render(&x, bandlimited_analysis_in, dc, out, block);
+			bandlimited_osc_render(&y, bandlimited_analysis_in, dc, twin, block);
+			for(j = 0; pass > 0 && j < block; j++) {
+				d = fabs(out[j] - twin[j]);
+				if(d > worst) {
+					worst = d;
+					*at = bandlimited_analysis_in[j];
+				}
+			}
+		}
+	return worst;
+}
+
+/*
+ * This function prints the summary of one waveform: the mean cost and
+ * errors of every setting over the frequency grid. A * marks the settings
+ * that no other is both cheaper and cleaner than, alias and harmonic
+ * error together.
+ *
+ * param t_bandlimited_wave waveform type
+ * param t_bandlimited_setting * the settings
+ * param int number of settings
+ */
+static void bandlimited_analysis_summary(t_bandlimited_wave wave, t_bandlimited_setting *s, int n) {
+	double noise[BANDLIMITED_ANALYSIS_MAXSETTINGS];
+	int i, j, pareto;
+
+	for(i = 0; i < n; i++)
+		noise[i] = bandlimited_analysis_db(pow(10.0, s[i].alias / 10.0) + pow(10.0, s[i].error / 10.0));
+	printf("%s\n  %-12s %8s %6s %10s %10s %10s %10s\n", bandlimited_wavenames[wave], "mode", "cutoff", "max",
+		   "ns/sample", "alias dB", "worst dB", "error dB");
+	for(i = 0; i < n; i++) {
+		pareto = 1;
+		for(j = 0; j < n; j++)
+			if(j != i && s[j].ns <= s[i].ns && noise[j] <= noise[i] && (s[j].ns < s[i].ns || noise[j] < noise[i]))
+				pareto = 0;
+		printf("%c %-12s %8.0f %6u %10.2f %10.1f %10.1f %10.1f\n", pareto ? '*' : ' ', bandlimited_modenames[s[i].mode],
+			   s[i].cutoff, s[i].max, s[i].ns, s[i].alias, s[i].worstalias, s[i].error);
+	}
+	printf("\n");
+	fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+	const char *csvfile = "bandlimited_analysis.csv";
+	t_bandlimited_setting settings[BANDLIMITED_ANALYSIS_MAXSETTINGS];
+	t_bandlimited_osc probe;
+	t_bandlimited_wave wave;
+	float nyquist, freqs[64], at;
+	int waves = 0, bins[64], nbins = 0, nsettings = 0, jumps = 0, i, m, c, k, bin;
+	double hz, ns, alias, error, jump;
+	FILE *csv;
+
+	for(i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			csvfile = argv[++i];
+		else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+			bandlimited_analysis_runtime = atof(argv[++i]) / 1000.0;
+		else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+			bandlimited_analysis_sr = atof(argv[++i]);
+		else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+			bandlimited_analysis_tabsize = atoi(argv[++i]);
+		else if(bandlimited_wave_parse(argv[i], &wave) == 0)
+			waves |= 1 << wave;
+		else {
+			fprintf(stderr, "usage: %s [-o report.csv] [-t ms per run] [-r sample rate] [-s table size] [wave ...]\n", argv[0]);
+			return 1;
+		}
+	}
+	if(bandlimited_analysis_runtime <= 0.0 || bandlimited_analysis_sr <= 0.0f) {
+		fprintf(stderr, "%s: the run time and sample rate must be above 0\n", argv[0]);
+		return 1;
+	}
+	if(!waves)
+		waves = (1 << BANDLIMITED_PULSE + 1) - 1;
+	if(!(csv = fopen(csvfile, "w"))) {
+		fprintf(stderr, "%s: can't write %s\n", argv[0], csvfile);
+		return 1;
+	}
+
+	// half octaves from 10 hz to near nyquist, each on an odd bin with an exact frequency
+	nyquist = bandlimited_analysis_sr / 2.0f;
+	for(hz = 10.0; hz < 0.95 * nyquist && nbins < 64; hz *= sqrt(2.0)) {
+		bin = (int)(hz * BANDLIMITED_ANALYSIS_SIZE / bandlimited_analysis_sr) | 1;
+		freqs[nbins] = bandlimited_analysis_binfreq(&bin);
+		if(nbins == 0 || bin != bins[nbins - 1])
+			bins[nbins++] = bin;
+	}
+	for(m = BANDLIMITED_EXACT; m <= BANDLIMITED_CROSSFADE; m++)
+		for(c = 0; c < (int)(sizeof(bandlimited_analysis_cutoffs) / sizeof(*bandlimited_analysis_cutoffs)); c++)
+			for(k = 0; k < (int)(sizeof(bandlimited_analysis_max) / sizeof(*bandlimited_analysis_max)); k++) {
+				settings[nsettings].mode = m;
+				settings[nsettings].cutoff = c == 0 ? 0.0f : bandlimited_analysis_cutoffs[c] * nyquist;
+				settings[nsettings++].max = bandlimited_analysis_max[k];
+			}
+	for(i = 0; i < BANDLIMITED_ANALYSIS_SIZE; i++)
+		bandlimited_analysis_dc[i] = BANDLIMITED_ANALYSIS_DUTY;
+
+	bandlimited_tables_new();
+	// rounded the way the oscillators round it
+	bandlimited_osc_init(&probe, BANDLIMITED_SAW, BANDLIMITED_MAXHARMONICS, 0.0f, BANDLIMITED_EXACT);
+	bandlimited_osc_settabsize(&probe, bandlimited_analysis_tabsize);
+	bandlimited_analysis_tabsize = bandlimited_osc_tabsize(&probe);
+	fprintf(csv, "wave,mode,cutoff,max,freq,harmonics,ns_per_sample,samples_per_sec,alias_db,harmonic_error_db\n");
+	printf("crossfade sweeps, worst difference from a twin with a %g higher cutoff\n", BANDLIMITED_ANALYSIS_NUDGE);
+	for(wave = BANDLIMITED_SAW; wave <= BANDLIMITED_PULSE; wave++) {
+		if(!(waves & 1 << wave))
+			continue;
+		jump = bandlimited_analysis_sweep(wave, &at);
+		printf("  %-12s %10.6f at %8.1f hz %s\n", bandlimited_wavenames[wave], jump, at,
+			   jump > BANDLIMITED_ANALYSIS_JUMP ? "step" : "ok");
+		if(jump > BANDLIMITED_ANALYSIS_JUMP)
+			jumps++;
+	}
+	printf("\n");
+	printf("%d frequencies from %.1f to %.0f hz at %.0f hz, %d point tables, cutoff 0 is nyquist, dB below the ideal signal\n\n",
+		   nbins, freqs[0], freqs[nbins - 1], bandlimited_analysis_sr, bandlimited_analysis_tabsize);
+	for(wave = BANDLIMITED_SAW; wave <= BANDLIMITED_PULSE; wave++) {
+		if(!(waves & 1 << wave))
+			continue;
+		for(i = 0; i < nsettings; i++) {
+			t_bandlimited_setting *s = &settings[i];
+
+			s->rows = 0;
+			s->ns = s->alias = s->error = 0.0;
+			s->worstalias = BANDLIMITED_ANALYSIS_FLOOR;
+			for(k = 0; k < nbins; k++) {
+				hz = freqs[k];
+				ns = bandlimited_analysis_run(wave, s, bins[k], freqs[k], &alias, &error);
+				fprintf(csv, "%s,%s,%.0f,%u,%.3f,%u,%.3f,%.0f,%.2f,%.2f\n", bandlimited_wavenames[wave], bandlimited_modenames[s->mode],
+						s->cutoff, s->max, hz, (unsigned int)fmin((s->cutoff == 0.0f ? nyquist - 1 : s->cutoff) / hz, s->max),
+						ns, 1e9 / ns, alias, error);
+				s->rows++;
+				s->ns += ns;
+				s->alias += alias;
+				s->error += error;
+				if(alias > s->worstalias)
+					s->worstalias = alias;
+			}
+			s->ns /= s->rows;
+			s->alias /= s->rows;
+			s->error /= s->rows;
+		}
+		bandlimited_analysis_summary(wave, settings, nsettings);
+	}
+	fclose(csv);
+	// cache files may still be being written for the waveforms picked
+	bandlimited_tables_wait();
+	bandlimited_tables_free();
+	printf("every frequency is in %s\n", csvfile);
+	if(jumps) {
+		fprintf(stderr, "%s: %d crossfade sweeps step\n", argv[0], jumps);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,359 @@
+/**
+
+
+Apache License 2.0
+
+bandlimited~
+    Copyright [2010] Paulo Casaes
+
+      This product includes software developed at
+      Github (https://github.com/pcasaes/bandlimited).
+
+ --
+ https://github.com/pcasaes/bandlimited
+ mailto:pcasaes@gmail.com
+
+ v 0.93
+ */
+
+/*
+ * Standalone benchmark of the oscillator core, see make bench. It times
+ * the wavetable generation and then renders every waveform in every mode
+ * over a sweep of frequencies, block sizes and frequency inputs, printing
+ * ns/sample and samples/sec of each case. Every case is run several times
+ * and the fastest run is reported, which is what stays put between runs.
+ * The cache files it writes go in a temporary directory that's removed
+ * when it's done.
+ *
+ * usage: bandlimited_bench [-t ms per run] [-r sample rate] [-s table size] [wave ...]
+ */
+
+#if defined(__unix__) || defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#define BANDLIMITED_BENCH_TMPDIR
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bandlimited_core.h"
+#include "bandlimited_util.h"
+
+#define BANDLIMITED_BENCH_RUNS 5
+#define BANDLIMITED_BENCH_BUILDS 3
+#define BANDLIMITED_BENCH_MAXBLOCK 4096
+#define BANDLIMITED_BENCH_INPUT 65536			// samples of input, a multiple of every block size
+#define BANDLIMITED_BENCH_CACHE "bandlimited_bench.tables"
+// enough harmonics that the lowest frequencies run past the wavetables onto the polyBLEPs
+#define BANDLIMITED_BENCH_NOLIMIT (1u << 16)
+
+typedef enum _bandlimited_input
+	{
+		BANDLIMITED_CONSTANT = 0,
+		BANDLIMITED_VIBRATO,
+		BANDLIMITED_SWEEP
+	} t_bandlimited_input;
+
+static const char *bandlimited_wavenames[] = {"saw", "rsaw", "square", "triangle", "sawtriangle", "pulse"};
+static const char *bandlimited_modenames[] = {"exact", "approximate", "crossfade"};
+static const char *bandlimited_inputnames[] = {"constant", "vibrato", "sweep"};
+static const int bandlimited_bench_blocks[] = {1, 16, 64, 256, 1024, 4096};
+
+static float bandlimited_bench_in[BANDLIMITED_BENCH_INPUT];
+static float bandlimited_bench_dc[BANDLIMITED_BENCH_INPUT];
+static float bandlimited_bench_out[BANDLIMITED_BENCH_MAXBLOCK];
+static double bandlimited_bench_runtime = 0.02;
+static float bandlimited_bench_sr = 44100.0f;
+static int bandlimited_bench_tabsize = 0;
+static int bandlimited_bench_waves = 0;
+static char bandlimited_bench_dir[1024] = "";
+static char bandlimited_bench_cache[1100] = BANDLIMITED_BENCH_CACHE;
+static char bandlimited_bench_cachefile[1200] = BANDLIMITED_BENCH_CACHE;
+
+/*
+ * This function fills the input buffers. A constant input holds the
+ * frequency, vibrato wobbles it by a semitone at 5 hz and a sweep rises
+ * exponentially from 20 hz to just below nyquist, over and over. Only
+ * audio rate inputs modulate the duty cycle.
+ *
+ * param t_bandlimited_input kind of input
+ * param float frequency in hz, ignored by the sweep
+ */
+static void bandlimited_bench_fill(t_bandlimited_input input, float f) {
+	float top = 0.45f * bandlimited_bench_sr;
+	int i;
+
+	for(i = 0; i < BANDLIMITED_BENCH_INPUT; i++) {
+		switch(input) {
+			case BANDLIMITED_CONSTANT:
+				bandlimited_bench_in[i] = f;
+				break;
+			case BANDLIMITED_VIBRATO:
+				bandlimited_bench_in[i] = f * powf(2.0f, sinf(2.0f * BANDLIMITED_PI * 5.0f * i / bandlimited_bench_sr) / 12.0f);
+				break;
+			case BANDLIMITED_SWEEP:
+				bandlimited_bench_in[i] = 20.0f * powf(top / 20.0f, (float)i / BANDLIMITED_BENCH_INPUT);
+				break;
+		}
+		bandlimited_bench_dc[i] = 0.5f + 0.4f * sinf(2.0f * BANDLIMITED_PI * 0.5f * i / bandlimited_bench_sr);
+	}
+}
+
+/*
+ * This function times one oscillator setting. The oscillator renders
+ * blocks from the input buffers until a run lasts bandlimited_bench_runtime,
+ * after a run to warm the caches and the lazy wavetables up.
+ *
+ * param t_bandlimited_wave waveform type
+ * param t_bandlimited_mode generator mode
+ * param unsigned int max number of harmonics
+ * param int block size
+ * param int 1 to modulate the duty cycle, pulse only
+ *
+ * return double ns per sample of the fastest run
+ */
+static double bandlimited_bench_time(t_bandlimited_wave wave, t_bandlimited_mode mode, unsigned int max_harmonics, int n, int dutycycle) {
+	t_bandlimited_osc x;
+	double start, elapsed, best = 0.0;
+	long samples;
+	int run, pos = 0, batch = n < 1024 ? 1024 / n : 1, b;
+
+	bandlimited_osc_init(&x, wave, max_harmonics, 0.0f, mode);
+	bandlimited_osc_settabsize(&x, bandlimited_bench_tabsize);
+	bandlimited_osc_setsr(&x, bandlimited_bench_sr);
+	for(run = 0; run <= BANDLIMITED_BENCH_RUNS; run++) {
+		samples = 0;
+		start = bandlimited_clock();
+		do {
+			for(b = 0; b < batch; b++) {
+				bandlimited_osc_render(&x, bandlimited_bench_in + pos, dutycycle ? bandlimited_bench_dc + pos : 0, bandlimited_bench_out, n);
+				pos = (pos + n) % BANDLIMITED_BENCH_INPUT;
+			}
+			samples += batch * n;
+			elapsed = bandlimited_clock() - start;
+		} while(elapsed < bandlimited_bench_runtime);
+		// run 0 is the warm up
+		if(run > 0 && (run == 1 || elapsed / samples < best))
+			best = elapsed / samples;
+	}
+	return best * 1e9;
+}
+
+/*
+ * This function prints one timed case.
+ */
+static void bandlimited_bench_report(t_bandlimited_wave wave, t_bandlimited_mode mode, unsigned int max_harmonics, float f, int n, t_bandlimited_input input) {
+	double ns = bandlimited_bench_time(wave, mode, max_harmonics, n, input != BANDLIMITED_CONSTANT);
+	char freq[16];
+
+	if(input == BANDLIMITED_SWEEP)
+		strcpy(freq, "20-nq");
+	else
+		snprintf(freq, sizeof(freq), "%g", f);
+	printf("%-12s %-12s %8s %6u %6d %-9s %10.2f %14.0f\n", bandlimited_wavenames[wave], bandlimited_modenames[mode],
+		   freq, max_harmonics, n, bandlimited_inputnames[input], ns, 1e9 / ns);
+	fflush(stdout);
+}
+
+/*
+ * This function creates the table set for the sample rate, the way the
+ * first oscillator at that rate does, picks every waveform with tables of
+ * its own so they're all built or loaded, waits for the ones built on
+ * worker threads and drops it again. The set's cache file is kept in
+ * bandlimited_bench_cachefile.
+ *
+ * param unsigned int * where the number of levels per waveform is stored
+ * param int * where the number of threads that built the tables is stored, may be NULL
+ *
+ * return double seconds it took
+ */
+static double bandlimited_bench_set(unsigned int *levels, int *threads) {
+	static const t_bandlimited_wave waves[] = {BANDLIMITED_TRIANGLE, BANDLIMITED_SQUARE, BANDLIMITED_SAWTRIANGLE};
+	t_bandlimited_osc x;
+	double start = bandlimited_clock(), elapsed;
+	int i;
+
+	bandlimited_tables_new();
+	bandlimited_osc_init(&x, BANDLIMITED_SAW, BANDLIMITED_MAXHARMONICS, 0.0f, BANDLIMITED_EXACT);
+	bandlimited_osc_settabsize(&x, bandlimited_bench_tabsize);
+	bandlimited_osc_setsr(&x, bandlimited_bench_sr);
+	for(i = 0; i < 3; i++)
+		bandlimited_osc_settype(&x, waves[i]);
+	bandlimited_tables_wait();
+	elapsed = bandlimited_clock() - start;
+	bandlimited_tableset_time(x.set, threads);
+	bandlimited_bench_tabsize = bandlimited_osc_tabsize(&x);
+	*levels = bandlimited_tableset_levels(x.set);
+	if(bandlimited_tableset_cachefile(x.set)[0])
+		snprintf(bandlimited_bench_cachefile, sizeof(bandlimited_bench_cachefile), "%s", bandlimited_tableset_cachefile(x.set));
+	bandlimited_tables_free();
+	return elapsed;
+}
+
+/*
+ * This function times creating the wavetables for the sample rate:
+ * building every table, with as many threads as there are processors,
+ * loading them back from a cache file, and setting up lazy tables, which
+ * only builds the first level of each waveform. The tables are left
+ * loaded from the cache for the rendering benchmarks.
+ */
+static void bandlimited_bench_tables(void) {
+	double best = 0.0, elapsed;
+	unsigned int levels = 0;
+	int i, threads = 0;
+
+	bandlimited_tables_setcache(bandlimited_bench_cache);
+	// the sets of wider bands and other sizes add to the name, see bandlimited_tables_setcache
+	bandlimited_bench_set(&levels, 0);
+	for(i = 0; i < BANDLIMITED_BENCH_BUILDS; i++) {
+		remove(bandlimited_bench_cachefile);
+		elapsed = bandlimited_bench_set(&levels, &threads);
+		if(i == 0 || elapsed < best)
+			best = elapsed;
+	}
+	printf("wavetables: %u levels of %d points per waveform at %.0f hz, %d harmonics at most\n",
+		   levels, bandlimited_bench_tabsize, bandlimited_bench_sr, BANDLIMITED_MAXHARMONICS);
+	printf("  build %10.2f ms (%d threads)\n", 1000 * best, threads);
+	for(i = 0; i < BANDLIMITED_BENCH_BUILDS; i++) {
+		elapsed = bandlimited_bench_set(&levels, 0);
+		if(i == 0 || elapsed < best)
+			best = elapsed;
+	}
+	printf("  load  %10.2f ms\n", 1000 * best);
+	bandlimited_tables_setcache("");
+	for(i = 0; i < BANDLIMITED_BENCH_BUILDS; i++) {
+		elapsed = bandlimited_bench_set(&levels, 0);
+		if(i == 0 || elapsed < best)
+			best = elapsed;
+	}
+	printf("  lazy  %10.2f ms\n\n", 1000 * best);
+	bandlimited_tables_setcache(bandlimited_bench_cache);
+	bandlimited_tables_new();
+}
+
+/*
+ * This function makes a temporary directory for the cache files, so the
+ * benchmark leaves nothing behind, see bandlimited_bench_cleanup. Where
+ * there's none they go in the current directory.
+ */
+static void bandlimited_bench_cachedir(void) {
+#ifdef BANDLIMITED_BENCH_TMPDIR
+	const char *tmp = getenv("TMPDIR");
+
+	snprintf(bandlimited_bench_dir, sizeof(bandlimited_bench_dir), "%s/bandlimited_bench.XXXXXX", tmp && *tmp ? tmp : "/tmp");
+	if(mkdtemp(bandlimited_bench_dir)) {
+		snprintf(bandlimited_bench_cache, sizeof(bandlimited_bench_cache), "%s/%s", bandlimited_bench_dir, BANDLIMITED_BENCH_CACHE);
+		strcpy(bandlimited_bench_cachefile, bandlimited_bench_cache);
+		return;
+	}
+	bandlimited_bench_dir[0] = 0;
+#endif
+}
+
+/*
+ * This function removes the cache files, every set's, and their directory.
+ */
+static void bandlimited_bench_cleanup(void) {
+#ifdef BANDLIMITED_BENCH_TMPDIR
+	char path[2048];
+	struct dirent *e;
+	DIR *d;
+
+	if(bandlimited_bench_dir[0] && (d = opendir(bandlimited_bench_dir))) {
+		while((e = readdir(d)))
+			if(strcmp(e->d_name, ".") != 0 && strcmp(e->d_name, "..") != 0) {
+				snprintf(path, sizeof(path), "%s/%s", bandlimited_bench_dir, e->d_name);
+				remove(path);
+			}
+		closedir(d);
+		rmdir(bandlimited_bench_dir);
+		return;
+	}
+#endif
+	remove(bandlimited_bench_cachefile);
+}
+
+int main(int argc, char **argv) {
+	const float freqs[] = {5.0f, 15.0f, 55.0f, 220.0f, 880.0f, 3520.0f, 12000.0f, 0.45f};
+	const int nfreqs = sizeof(freqs) / sizeof(*freqs);
+	const float lows[] = {5.0f, 10.0f, 15.0f};
+	const int nlows = sizeof(lows) / sizeof(*lows);
+	t_bandlimited_wave wave;
+	int i, m, f, n;
+
+	for(i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+			bandlimited_bench_runtime = atof(argv[++i]) / 1000.0;
+		else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+			bandlimited_bench_sr = atof(argv[++i]);
+		else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+			bandlimited_bench_tabsize = atoi(argv[++i]);
+		else if(bandlimited_wave_parse(argv[i], &wave) == 0)
+			bandlimited_bench_waves |= 1 << wave;
+		else {
+			fprintf(stderr, "usage: %s [-t ms per run] [-r sample rate] [-s table size] [wave ...]\n", argv[0]);
+			return 1;
+		}
+	}
+	if(bandlimited_bench_runtime <= 0.0 || bandlimited_bench_sr <= 0.0f) {
+		fprintf(stderr, "%s: the run time and sample rate must be above 0\n", argv[0]);
+		return 1;
+	}
+	if(!bandlimited_bench_waves)
+		bandlimited_bench_waves = (1 << BANDLIMITED_PULSE + 1) - 1;
+
+	bandlimited_bench_cachedir();
+	bandlimited_bench_tables();
+	printf("%d runs of %.0f ms per case at %.0f hz, fastest run\n\n", BANDLIMITED_BENCH_RUNS,
+		   1000 * bandlimited_bench_runtime, bandlimited_bench_sr);
+	printf("%-12s %-12s %8s %6s %6s %-9s %10s %14s\n", "wave", "mode", "freq", "max", "block", "input", "ns/sample", "samples/sec");
+
+	// every waveform and mode over the frequency range, in 64 sample blocks
+	for(wave = BANDLIMITED_SAW; wave <= BANDLIMITED_PULSE; wave++)
+		if(bandlimited_bench_waves & 1 << wave)
+			for(m = BANDLIMITED_EXACT; m <= BANDLIMITED_CROSSFADE; m++)
+				for(f = 0; f < nfreqs; f++) {
+					// the last frequency is a fraction of the sample rate, near nyquist
+					float hz = freqs[f] < 1.0f ? freqs[f] * bandlimited_bench_sr : freqs[f];
+
+					bandlimited_bench_fill(BANDLIMITED_CONSTANT, hz);
+					bandlimited_bench_report(wave, m, BANDLIMITED_MAXHARMONICS, hz, 64, BANDLIMITED_CONSTANT);
+				}
+	printf("\n");
+
+	// the lowest frequencies without a limit on the harmonics, past the wavetables
+	for(wave = BANDLIMITED_SAW; wave <= BANDLIMITED_PULSE; wave++)
+		if(bandlimited_bench_waves & 1 << wave)
+			for(m = BANDLIMITED_EXACT; m <= BANDLIMITED_CROSSFADE; m++)
+				for(f = 0; f < nlows; f++) {
+					bandlimited_bench_fill(BANDLIMITED_CONSTANT, lows[f]);
+					bandlimited_bench_report(wave, m, BANDLIMITED_BENCH_NOLIMIT, lows[f], 64, BANDLIMITED_CONSTANT);
+				}
+	printf("\n");
+
+	// block sizes, at 220 hz
+	bandlimited_bench_fill(BANDLIMITED_CONSTANT, 220.0f);
+	for(wave = BANDLIMITED_SAW; wave <= BANDLIMITED_PULSE; wave++)
+		if(bandlimited_bench_waves & 1 << wave)
+			for(m = BANDLIMITED_EXACT; m <= BANDLIMITED_CROSSFADE; m++)
+				for(n = 0; n < (int)(sizeof(bandlimited_bench_blocks) / sizeof(*bandlimited_bench_blocks)); n++)
+					bandlimited_bench_report(wave, m, BANDLIMITED_MAXHARMONICS, 220.0f, bandlimited_bench_blocks[n], BANDLIMITED_CONSTANT);
+	printf("\n");
+
+	// constant against audio rate frequencies
+	for(wave = BANDLIMITED_SAW; wave <= BANDLIMITED_PULSE; wave++)
+		if(bandlimited_bench_waves & 1 << wave)
+			for(m = BANDLIMITED_EXACT; m <= BANDLIMITED_CROSSFADE; m++)
+				for(i = BANDLIMITED_CONSTANT; i <= BANDLIMITED_SWEEP; i++) {
+					bandlimited_bench_fill(i, 220.0f);
+					bandlimited_bench_report(wave, m, BANDLIMITED_MAXHARMONICS, 220.0f, 64, i);
+				}
+
+	bandlimited_tables_wait();
+	bandlimited_tables_free();
+	bandlimited_bench_cleanup();
+	return 0;
+}
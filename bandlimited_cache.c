@@ -0,0 +1,328 @@
+/**
+
+
+Apache License 2.0
+
+bandlimited~
+    Copyright [2010] Paulo Casaes
+
+      This product includes software developed at
+      Github (https://github.com/pcasaes/bandlimited).
+
+ --
+ https://github.com/pcasaes/bandlimited
+ mailto:pcasaes@gmail.com
+
+ v 0.93
+ */
+
+#if defined(__unix__) || defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "bandlimited_cache.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BANDLIMITED_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define mkdir(d, m) _mkdir(d)
+#define getpid _getpid
+#endif
+
+
+#define BANDLIMITED_CACHE_MAGIC "BLTABLES"
+
+typedef struct _bandlimited_cacheheader
+	{
+		char magic[8];
+		uint32_t version;
+		t_bandlimited_cachekey key;
+		uint64_t sums[BANDLIMITED_CACHE_WAVES];	/* of the tables of each waveform there, in order */
+		uint64_t checksum;
+	} t_bandlimited_cacheheader;
+
+
+/*
+ * This function hashes a block of bytes (FNV-1a).
+ *
+ * param uint64_t hash so far
+ * param const void * data
+ * param size_t number of bytes
+ *
+ * return uint64_t updated hash
+ */
+static uint64_t bandlimited_cache_hash(uint64_t h, const void *data, size_t n) {
+	const unsigned char *b = (const unsigned char *)data;
+	size_t i;
+
+	for(i = 0; i < n; i++) {
+		h ^= b[i];
+		h *= 1099511628211ull;
+	}
+	return h;
+}
+
+/*
+ * This function sums the tables of a waveform 8 bytes at a time, in 4
+ * independent lanes so a whole file is checked in a fraction of a
+ * millisecond. Each step is a bijection of its lane, any one word that
+ * changes changes the sum.
+ *
+ * param const void * tables
+ * param size_t number of bytes
+ *
+ * return uint64_t sum
+ */
+static uint64_t bandlimited_cache_sum(const void *data, size_t n) {
+	const unsigned char *b = (const unsigned char *)data;
+	uint64_t h[4] = {14695981039346656037ull, 1, 2, 3}, w;
+	size_t i;
+	int l;
+
+	for(i = 0; i + 32 <= n; i += 32)
+		for(l = 0; l < 4; l++) {
+			memcpy(&w, b + i + 8 * l, 8);
+			h[l] = (h[l] ^ w) * 1099511628211ull;
+			h[l] ^= h[l] >> 32;
+		}
+	// the other lanes and what's left over are folded into the first
+	return bandlimited_cache_hash(bandlimited_cache_hash(h[0], h + 1, 3 * sizeof(uint64_t)), b + i, n - i);
+}
+
+/*
+ * This function fills in a file header, its checksum is the hash of the
+ * rest of the header.
+ *
+ * param t_bandlimited_cacheheader * header to fill in
+ * param const t_bandlimited_cachekey * key
+ * param const uint64_t * sum of the tables of each waveform in the file, in order
+ */
+static void bandlimited_cache_header(t_bandlimited_cacheheader *h, const t_bandlimited_cachekey *key, const uint64_t *sums) {
+	memset(h, 0, sizeof(*h));
+	memcpy(h->magic, BANDLIMITED_CACHE_MAGIC, 8);
+	h->version = BANDLIMITED_CACHE_VERSION;
+	h->key = *key;
+	memcpy(h->sums, sums, sizeof(h->sums));
+	h->checksum = bandlimited_cache_hash(14695981039346656037ull, h, sizeof(*h));
+}
+
+/*
+ * This function builds the path of a cache file inside the user's cache
+ * directory ($XDG_CACHE_HOME, ~/.cache or %LOCALAPPDATA%), creating the
+ * bandlimited directory in there if needed. The BANDLIMITED_CACHE
+ * environment variable overrides the directory, setting it empty turns the
+ * cache off.
+ *
+ * param char * where the path is stored
+ * param size_t size of the buffer
+ * param const char * file name
+ *
+ * return int 0 on sucess, 1 if there is no cache directory
+ */
+int bandlimited_cache_path(char *path, size_t len, const char *name) {
+	const char *dir = getenv("BANDLIMITED_CACHE");
+	const char *base;
+	char sub[1024];
+
+	if(dir) {
+		if(!*dir)
+			return 1;
+	} else {
+		if((base = getenv("XDG_CACHE_HOME")) && *base)
+			snprintf(sub, sizeof(sub), "%s/bandlimited", base);
+		else if((base = getenv("HOME")) && *base) {
+			snprintf(sub, sizeof(sub), "%s/.cache", base);
+			mkdir(sub, 0755);
+			snprintf(sub, sizeof(sub), "%s/.cache/bandlimited", base);
+		} else if((base = getenv("LOCALAPPDATA")) && *base)
+			snprintf(sub, sizeof(sub), "%s/bandlimited", base);
+		else
+			return 1;
+		mkdir(sub, 0755);
+		dir = sub;
+	}
+	return snprintf(path, len, "%s/%s", dir, name) >= (int)len;
+}
+
+/*
+ * This function opens a cache file and checks it against the key and its
+ * tables against their sums. The file may hold any of the waveforms of
+ * the key, the ones it has are one after the other in the order of their
+ * bits.
+ *
+ * param t_bandlimited_cache * cache to fill in
+ * param const char * path of the cache file
+ * param const t_bandlimited_cachekey * what the tables must have been built
+ *				with, waves has a bit for every waveform there may be
+ * param const size_t * size in bytes of the tables of each of the
+ *				BANDLIMITED_CACHE_WAVES waveforms
+ * param uint32_t * where the waveforms the file holds are stored
+ *
+ * return int 0 on sucess, 1 if the file is missing, doesn't match or is damaged
+ */
+int bandlimited_cache_load(t_bandlimited_cache *c, const char *path, const t_bandlimited_cachekey *key, const size_t *wavebytes, uint32_t *waves) {
+	size_t size = 0, expect = BANDLIMITED_CACHE_HEADER;
+	t_bandlimited_cacheheader expected;
+	t_bandlimited_cachekey stored;
+	const t_bandlimited_cacheheader *h;
+	const char *tables;
+	int w, n;
+
+	c->data = 0;
+	c->size = 0;
+	c->mapped = 0;
+	*waves = 0;
+
+#ifdef BANDLIMITED_MMAP
+	{
+		struct stat st;
+		int fd = open(path, O_RDONLY);
+
+		if(fd < 0)
+			return 1;
+		if(fstat(fd, &st) != 0 || (size_t)st.st_size < BANDLIMITED_CACHE_HEADER) {
+			close(fd);
+			return 1;
+		}
+		size = st.st_size;
+		c->data = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if(c->data == MAP_FAILED) {
+			c->data = 0;
+			return 1;
+		}
+		c->mapped = 1;
+	}
+#else
+	{
+		FILE *fp = fopen(path, "rb");
+		long len;
+
+		if(!fp)
+			return 1;
+		if(fseek(fp, 0, SEEK_END) != 0 || (len = ftell(fp)) < BANDLIMITED_CACHE_HEADER || fseek(fp, 0, SEEK_SET) != 0) {
+			fclose(fp);
+			return 1;
+		}
+		size = len;
+		c->data = malloc(size);
+		if(!c->data || fread(c->data, 1, size, fp) != size) {
+			fclose(fp);
+			free(c->data);
+			c->data = 0;
+			return 1;
+		}
+		fclose(fp);
+	}
+#endif
+	c->size = size;
+
+	h = (const t_bandlimited_cacheheader *)c->data;
+	stored = *key;
+	stored.waves = h->key.waves;
+	// the header isn't trusted until it's checked, a stray bit mustn't index wavebytes
+	if((stored.waves & ~key->waves) || (stored.waves >> BANDLIMITED_CACHE_WAVES) || !stored.waves) {
+		bandlimited_cache_unload(c);
+		return 1;
+	}
+	bandlimited_cache_header(&expected, &stored, h->sums);
+	for(w = 0; w < BANDLIMITED_CACHE_WAVES; w++)
+		if(stored.waves & (1u << w))
+			expect += wavebytes[w];
+	if(memcmp(h, &expected, sizeof(expected)) != 0 || size != expect) {
+		bandlimited_cache_unload(c);
+		return 1;
+	}
+	tables = (const char *)bandlimited_cache_tables(c);
+	for(w = 0, n = 0; w < BANDLIMITED_CACHE_WAVES; w++)
+		if(stored.waves & (1u << w)) {
+			if(bandlimited_cache_sum(tables, wavebytes[w]) != h->sums[n++]) {
+				bandlimited_cache_unload(c);
+				return 1;
+			}
+			tables += wavebytes[w];
+		}
+	*waves = stored.waves;
+	return 0;
+}
+
+/*
+ * return const void * the first table of a loaded cache
+ */
+const void *bandlimited_cache_tables(const t_bandlimited_cache *c) {
+	return (const char *)c->data + BANDLIMITED_CACHE_HEADER;
+}
+
+void bandlimited_cache_unload(t_bandlimited_cache *c) {
+	if(!c->data)
+		return;
+#ifdef BANDLIMITED_MMAP
+	if(c->mapped)
+		munmap(c->data, c->size);
+	else
+#endif
+		free(c->data);
+	c->data = 0;
+	c->size = 0;
+	c->mapped = 0;
+}
+
+/*
+ * This function writes tables to a cache file. It writes to a temporary
+ * file first and renames it so nobody ever maps a half written cache.
+ *
+ * param const char * path of the cache file
+ * param const t_bandlimited_cachekey * what the tables were built with,
+ *				waves has a bit for every waveform written
+ * param const void *const * tables of each waveform to write, in order
+ * param const size_t * size of the tables of each waveform in bytes
+ * param int number of waveforms, up to BANDLIMITED_CACHE_WAVES
+ *
+ * return int 0 on sucess, 1 on failure
+ */
+int bandlimited_cache_save(const char *path, const t_bandlimited_cachekey *key, const void *const *tables, const size_t *sizes, int ntables) {
+	char tmp[1100];
+	char header[BANDLIMITED_CACHE_HEADER];
+	t_bandlimited_cacheheader h;
+	uint64_t sums[BANDLIMITED_CACHE_WAVES] = {0};
+	FILE *fp;
+	int i, failed = 0;
+
+	if(ntables > BANDLIMITED_CACHE_WAVES)
+		return 1;
+	for(i = 0; i < ntables; i++)
+		sums[i] = bandlimited_cache_sum(tables[i], sizes[i]);
+	bandlimited_cache_header(&h, key, sums);
+	memset(header, 0, sizeof(header));
+	memcpy(header, &h, sizeof(h));
+
+	if(snprintf(tmp, sizeof(tmp), "%s.%ld.tmp", path, (long)getpid()) >= (int)sizeof(tmp))
+		return 1;
+	if(!(fp = fopen(tmp, "wb")))
+		return 1;
+	failed = fwrite(header, 1, sizeof(header), fp) != sizeof(header);
+	for(i = 0; i < ntables && !failed; i++)
+		failed = fwrite(tables[i], 1, sizes[i], fp) != sizes[i];
+	failed |= fclose(fp) != 0;
+#ifdef _WIN32
+	if(!failed)
+		remove(path);
+#endif
+	if(failed || rename(tmp, path) != 0) {
+		remove(tmp);
+		return 1;
+	}
+	return 0;
+}
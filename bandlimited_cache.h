@@ -0,0 +1,75 @@
+/**
+
+
+Apache License 2.0
+
+bandlimited~
+    Copyright [2010] Paulo Casaes
+
+      This product includes software developed at
+      Github (https://github.com/pcasaes/bandlimited).
+
+ --
+ https://github.com/pcasaes/bandlimited
+ mailto:pcasaes@gmail.com
+
+ v 0.93
+ */
+
+/*
+ * On disk wavetable cache. A cache file is a small header followed by the
+ * tables of the waveforms it holds as raw samples, laid out as in memory:
+ * one waveform after the other, each table padded to start on a 64 byte
+ * boundary. The header records everything the tables depend on and which
+ * waveforms are in the file, so a file from another build or machine is
+ * never used. It also holds a checksum of the tables of each waveform,
+ * all of them are checked once when the file is loaded, so tables damaged
+ * on disk are built again and the file rewritten rather than played.
+ * Files are only ever replaced whole, by a rename, and their size is
+ * checked. Files are mapped read only where the platform allows it.
+ */
+
+#ifndef BANDLIMITED_CACHE_H_
+#define BANDLIMITED_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* bump whenever the way tables are generated changes */
+#define BANDLIMITED_CACHE_VERSION 8
+
+/* waveforms with their own tables: saw, triangle, square, sawtriangle */
+#define BANDLIMITED_CACHE_WAVES 4
+
+/* size of the file header, the tables start right after it */
+#define BANDLIMITED_CACHE_HEADER 128
+
+
+typedef struct _bandlimited_cachekey
+	{
+		uint32_t tabsize;
+		uint32_t increment;
+		uint32_t hamsize;
+		uint32_t waves;		/* one bit per waveform stored */
+		uint32_t samplesize;
+		uint32_t format;	/* how samples are stored, see t_bandlimited_sample */
+		uint32_t folds;		/* how much of the period each waveform stores */
+		uint32_t layout;	/* hash of the harmonics of every level */
+		float one;			/* 1.0f, catches byte order and float format */
+	} t_bandlimited_cachekey;
+
+typedef struct _bandlimited_cache
+	{
+		void *data;
+		size_t size;
+		int mapped;
+	} t_bandlimited_cache;
+
+
+int bandlimited_cache_path(char *path, size_t len, const char *name);
+int bandlimited_cache_load(t_bandlimited_cache *c, const char *path, const t_bandlimited_cachekey *key, const size_t *wavebytes, uint32_t *waves);
+const void *bandlimited_cache_tables(const t_bandlimited_cache *c);
+void bandlimited_cache_unload(t_bandlimited_cache *c);
+int bandlimited_cache_save(const char *path, const t_bandlimited_cachekey *key, const void *const *tables, const size_t *sizes, int ntables);
+
+#endif /*BANDLIMITED_CACHE_H_*/
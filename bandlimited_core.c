@@ -0,0 +1,2767 @@
+/**
+ 
+ 
+Apache License 2.0
+
+bandlimited~
+    Copyright [2010] Paulo Casaes
+
+      This product includes software developed at
+      Github (https://github.com/pcasaes/bandlimited).
+ 
+ -- 
+ https://github.com/pcasaes/bandlimited
+ mailto:pcasaes@gmail.com
+ 
+ v 0.93
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bandlimited_core.h"
+#include "bandlimited_util.h"
+#include "bandlimited_cache.h"
+
+
+
+static long bandlimited_count=0l;
+/* small and shared by every set, so it's never allocated and can't fail */
+static float bandlimited_sin_table[BANDLIMITED_TABSIZE+3] __attribute__((aligned(BANDLIMITED_TABLEALIGN)));
+static int bandlimited_sin_made=0;
+
+static char bandlimited_cachepath[1024];
+static int bandlimited_cacheset=0;
+
+static size_t bandlimited_budget=BANDLIMITED_BUDGET;
+static int bandlimited_budgetset=0;
+
+static int bandlimited_hugepages=BANDLIMITED_HUGEPAGES;
+static int bandlimited_hugepagesset=0;
+
+#define bandlimited_read(q,w) bandlimited_read4((q),(w))
+
+#define BANDLIMITED_CACHE_NAME "bandlimited-%d-%d-%u%s" BANDLIMITED_FORMAT_NAME BANDLIMITED_FOLD_NAME ".tables"
+
+#define BANDLIMITED_SAWTABLE 0
+#define BANDLIMITED_TRIANGLETABLE 1
+#define BANDLIMITED_SQUARETABLE 2
+#define BANDLIMITED_SAWTRIANGLETABLE 3
+
+/*
+ * Built with -DBANDLIMITED_SYMMETRIC the wavetables only hold the part of
+ * the period the rest folds back onto: saw and sawtriangle are odd, so half
+ * a period is enough, square and triangle are also symmetric about a
+ * quarter period. This is how many times each period folds.
+ */
+#ifdef BANDLIMITED_SYMMETRIC
+#define BANDLIMITED_SAWFOLD 2
+#define BANDLIMITED_TRIANGLEFOLD 4
+#define BANDLIMITED_SQUAREFOLD 4
+#define BANDLIMITED_SAWTRIANGLEFOLD 2
+#define BANDLIMITED_FOLD_NAME "-sym"
+#else
+#define BANDLIMITED_SAWFOLD 1
+#define BANDLIMITED_TRIANGLEFOLD 1
+#define BANDLIMITED_SQUAREFOLD 1
+#define BANDLIMITED_SAWTRIANGLEFOLD 1
+#define BANDLIMITED_FOLD_NAME ""
+#endif
+
+/* points in a wavetable of 2^bits, a folded one needs a guard point past the fold too */
+#define BANDLIMITED_TABLEN(bits, fold) ((fold) > 1 ? (1 << (bits))/(fold) + 4 : (1 << (bits))+3)
+
+/* bytes a wavetable takes in a table set's arena, so the next one starts aligned */
+#define BANDLIMITED_TABSTRIDE(bits, fold) \
+	((BANDLIMITED_TABLEN(bits, fold) * sizeof(t_bandlimited_sample) + BANDLIMITED_TABLEALIGN - 1) & ~(size_t)(BANDLIMITED_TABLEALIGN - 1))
+
+/* in cache order: saw, triangle, square, sawtriangle */
+static const int bandlimited_folds[BANDLIMITED_CACHE_WAVES] = {
+	BANDLIMITED_SAWFOLD, BANDLIMITED_TRIANGLEFOLD, BANDLIMITED_SQUAREFOLD, BANDLIMITED_SAWTRIANGLEFOLD
+};
+
+/*
+ * A table set holds the harmonic levels and the wavetables of every
+ * waveform laid out for one band, see bandlimited_osc_setsr. Level i has
+ * levels[i] harmonics, the lookup tables map a number of harmonics
+ * (capped at BANDLIMITED_TOPHARMONICS) onto the position + 1 of the level
+ * below it and the level nearest to it. See bandlimited_dlayout.
+ */
+#define BANDLIMITED_TOPHARMONICS (BANDLIMITED_HAMSIZE * BANDLIMITED_INCREMENT)
+
+struct _bandlimited_tableset
+	{
+		//half octaves the band is above BANDLIMITED_AUDIBLE, see bandlimited_band
+		unsigned int band;
+		//log2 of the wavetable size and its block reader
+		int tabbits;
+		t_bandlimited_read4 read4;
+
+		//levels, the last one has top harmonics and is read up to reach
+		unsigned int top;
+		unsigned int reach;
+		unsigned int nlevels;
+		unsigned int levels[BANDLIMITED_HAMSIZE];
+		float levelspan[BANDLIMITED_HAMSIZE];
+		unsigned short levelfloor[BANDLIMITED_TOPHARMONICS+1];
+		unsigned short levelnearest[BANDLIMITED_TOPHARMONICS+1];
+
+		//wavetables of every level, in cache order, and the arena or the
+		//cache they're in. A pair of levels is claimed by whoever builds it
+		t_bandlimited_sample **tables[BANDLIMITED_CACHE_WAVES];
+		t_bandlimited_arena arena;
+		unsigned char claimed[BANDLIMITED_CACHE_WAVES][(BANDLIMITED_HAMSIZE+1)/2];
+		t_bandlimited_cache cache;
+		char cachefile[1024];
+		//bit per waveform with every level there, loaded or built for the
+		//cache, and per waveform being built for it on a worker thread
+		unsigned int cached;
+		unsigned int building;
+
+		//how the set was made
+		int status;
+		int threads;
+		double time;
+	};
+
+#define BANDLIMITED_TABSIZES (BANDLIMITED_MAXTABBITS - BANDLIMITED_MINTABBITS + 1)
+
+static t_bandlimited_tableset *bandlimited_sets[BANDLIMITED_TABSIZES][BANDLIMITED_MAXBANDS];
+
+
+
+/*
+ * This function performs sin(2pi *x) using the real sin function.
+ *
+ * param t_bandlimited_phase phase
+ *
+ * return double evaluation of sin function
+ */
+static inline double bandlimited_sin_real(t_bandlimited_phase p) {
+	return sin((2.0 * BANDLIMITED_PI / BANDLIMITED_PHASEONE)*p);
+}
+
+
+/*
+ * This function performs sin(2pi * x) using 4-point interpolation on top of a wavetable.
+ *
+ * param t_bandlimited_phase phase
+ *
+ * return double evaluation of sin function
+ */
+static inline double bandlimited_sin_4point(t_bandlimited_phase p) {
+	return bandlimited_read(bandlimited_sin_table, p);
+}
+
+/*
+ * This function selects the sin function being used. When building 
+ * the wave tables the real sin function should be used. When generating
+ * a signal the 4point interpolation sin wavetable function should be used.
+ * Callers pass a constant so the choice folds away once inlined.
+ *
+ * param t_bandlimited_phase phase
+ * param int 1 for the real sin function, 0 for the wavetable
+ *
+ * return double evaluation of sin function
+ */
+static inline double bandlimited_sin(t_bandlimited_phase p, int real) {
+	return real ? bandlimited_sin_real(p) : bandlimited_sin_4point(p);
+}
+
+
+/*
+ * calculates the wavetable position that is nearest to the number of 
+ * harmonics specified
+ *
+ * param const t_bandlimited_tableset * table set
+ * param unsigned int max harmonics to lookup
+ *
+ * return unsigned int wavetable position + 1
+ */
+static inline unsigned int bandlimited_harmpos(const t_bandlimited_tableset *set, unsigned int max_harmonics) {
+
+	return set->levelnearest[max_harmonics < BANDLIMITED_TOPHARMONICS ? max_harmonics : BANDLIMITED_TOPHARMONICS];
+
+}
+
+/*
+ * calculates the wavetable position that is nearest to and below the number of 
+ * harmonics specified
+ *
+ * param const t_bandlimited_tableset * table set
+ * param unsigned int max harmonics to lookup
+ *
+ * return unsigned int wavetable position + 1
+ */
+static inline unsigned int bandlimited_harmposfloor(const t_bandlimited_tableset *set, unsigned int max_harmonics) {
+
+	return set->levelfloor[max_harmonics < BANDLIMITED_TOPHARMONICS ? max_harmonics : BANDLIMITED_TOPHARMONICS];
+
+}
+
+
+
+/*
+ * calculates the two wavetable positions around the number of harmonics
+ * specified and how far the number of harmonics is between them
+ *
+ * param const t_bandlimited_tableset * table set
+ * param float number of harmonics
+ * param unsigned int * wavetable position + 1 at or below the number of harmonics,
+ *						the position above is the next one
+ *
+ * return float weight of the wavetable above
+ */
+static inline float bandlimited_harmposfrac(const t_bandlimited_tableset *set, float harmonics, unsigned int *pos) {
+
+	unsigned int p;
+
+	if(harmonics < set->levels[0]) {
+		*pos = 1;
+		return 0.0f;
+	}
+	p = harmonics < BANDLIMITED_TOPHARMONICS ? set->levelfloor[(unsigned int)harmonics] : set->nlevels;
+	if(p >= set->nlevels) {
+		*pos = set->nlevels-1;
+		return 1.0f;
+	}
+	*pos = p;
+	return (harmonics - set->levels[p-1]) * set->levelspan[p-1];
+
+}
+
+
+
+/*
+ * This function sums a sine series over the harmonics from start to
+ * max_harmonics, step apart: the k-th term is sign^k sin(2pi * h * p) / h^power
+ * with h = start + k*step. Only the first harmonic and the step are looked
+ * up, every next harmonic is a rotation away, so a term costs a complex
+ * multiplication instead of a sin lookup.
+ *
+ * param unsigned int starting harmonic
+ * param unsigned int stopping harmonic
+ * param unsigned int step between harmonics
+ * param double 1, or -1 to alternate the sign of the terms
+ * param int 1 or 2, power of the harmonic the terms are divided by
+ * param t_bandlimited_phase phase
+ * param int 1 to use the real sin function
+ *
+ * return double the sum
+ */
+static inline double bandlimited_sinsum(unsigned int start, unsigned int max_harmonics, unsigned int step, double sign, int power, t_bandlimited_phase p, int real) {
+	unsigned int i;
+	double sum = 0.0, s, c, ws, wc, t;
+	t_bandlimited_phase q;
+
+	if(start > max_harmonics)
+		return 0.0;
+	// a harmonic's phase is the phase times the harmonic, the whole periods wrap away
+	if(max_harmonics - start < 4 * step) {
+		// a few harmonics are cheaper looked up one by one
+		for(i = start, t = 1.0; i <= max_harmonics; i += step, t *= sign) {
+			q = p * i;
+			sum += t * (power == 2 ? bandlimited_sin(q, real) / ((double)i * i) : bandlimited_sin(q, real) / i);
+		}
+		return sum;
+	}
+	q = p * start;
+	s = bandlimited_sin(q, real);
+	c = bandlimited_sin(q + BANDLIMITED_PHASEQUARTER, real);
+	ws = sign * bandlimited_sin(p * step, real);
+	wc = sign * bandlimited_sin(p * step + BANDLIMITED_PHASEQUARTER, real);
+	for(i = start; i <= max_harmonics; i += step) {
+		sum += power == 2 ? s / ((double)i * i) : s / i;
+		t = c * wc - s * ws;
+		s = s * wc + c * ws;
+		c = t;
+	}
+	return sum;
+}
+
+/*
+ * This function calculates the harmonic components for a square wave on
+ * phase p from start to max_harmonics, only the odd ones are there
+ *
+ * param unsigned int starting harmonic
+ * param unsigned int stopping harmonic
+ * param t_bandlimited_phase phase
+ * param int 1 to use the real sin function
+ *
+ * return float the calculated wave component
+ */
+static inline float bandlimited_squarepart(unsigned int start, unsigned int max_harmonics, t_bandlimited_phase p, int real) {
+	start |= 1;
+	return 4.0f * bandlimited_sinsum(start, max_harmonics, 2, 1.0, 1, p, real) / BANDLIMITED_PI;
+}
+
+
+/*
+ * This function calculates the harmonic components for a triangle wave on
+ * phase p from start to max_harmonics, only the odd ones are there
+ *
+ * param unsigned int starting harmonic
+ * param unsigned int stopping harmonic
+ * param t_bandlimited_phase phase
+ * param int 1 to use the real sin function
+ *
+ * return float the calculated wave component
+ */
+static inline float bandlimited_trianglepart(unsigned int start, unsigned int max_harmonics, t_bandlimited_phase p, int real) {
+	start |= 1;
+	// (-1)^((i-1)/2): every other odd harmonic is negative
+	return (start%4==3 ? -8.0f : 8.0f) * bandlimited_sinsum(start, max_harmonics, 2, -1.0, 2, p, real) / BANDLIMITED_PISQ;
+}
+
+/*
+ * This function calculates the harmonic components for a sawtooth wave on
+ * phase p from start to max_harmonics
+ *
+ * param unsigned int starting harmonic
+ * param unsigned int stopping harmonic
+ * param t_bandlimited_phase phase
+ * param int 1 to use the real sin function
+ *
+ * return float the calculated wave component
+ */
+static inline float bandlimited_sawwavepart(unsigned int start, unsigned int max_harmonics, t_bandlimited_phase p, int real) {
+	return 2.0f * bandlimited_sinsum(start, max_harmonics, 1, 1.0, 1, p, real) / BANDLIMITED_PI;
+}
+
+/*
+ * This function calculates the sawtooth harmonic components at phase p2
+ * less those at phase p, what a pulse is made of. Both phases are summed in
+ * the same loop, see bandlimited_sinsum.
+ *
+ * param unsigned int starting harmonic
+ * param unsigned int stopping harmonic
+ * param t_bandlimited_phase phase of the falling edge
+ * param t_bandlimited_phase phase of the rising edge
+ *
+ * return float the calculated wave component
+ */
+static inline float bandlimited_sawwavepartpair(unsigned int start, unsigned int max_harmonics, t_bandlimited_phase p, t_bandlimited_phase p2) {
+	unsigned int i;
+	double sum = 0.0, s, c, ws, wc, s2, c2, ws2, wc2, t;
+	t_bandlimited_phase q, q2;
+
+	if(start > max_harmonics)
+		return 0.0f;
+	if(max_harmonics - start < 4) {
+		for(i = start; i <= max_harmonics; i++)
+			sum += (bandlimited_sin(p2 * i, 0) - bandlimited_sin(p * i, 0)) / i;
+		return 2.0f * sum / BANDLIMITED_PI;
+	}
+	q = p * start;
+	q2 = p2 * start;
+	s = bandlimited_sin(q, 0);
+	c = bandlimited_sin(q + BANDLIMITED_PHASEQUARTER, 0);
+	s2 = bandlimited_sin(q2, 0);
+	c2 = bandlimited_sin(q2 + BANDLIMITED_PHASEQUARTER, 0);
+	ws = bandlimited_sin(p, 0);
+	wc = bandlimited_sin(p + BANDLIMITED_PHASEQUARTER, 0);
+	ws2 = bandlimited_sin(p2, 0);
+	wc2 = bandlimited_sin(p2 + BANDLIMITED_PHASEQUARTER, 0);
+	for(i = start; i <= max_harmonics; i++) {
+		sum += (s2 - s) / i;
+		t = c * wc - s * ws;
+		s = s * wc + c * ws;
+		c = t;
+		t = c2 * wc2 - s2 * ws2;
+		s2 = s2 * wc2 + c2 * ws2;
+		c2 = t;
+	}
+	return 2.0f * sum / BANDLIMITED_PI;
+}
+
+/*
+ * This function calculates the harmonic components for a sawtooth-triangle wave on
+ * phase p from start to max_harmonics, a triangle less a sawtooth
+ *
+ * param unsigned int starting harmonic
+ * param unsigned int stopping harmonic
+ * param t_bandlimited_phase phase
+ * param int 1 to use the real sin function
+ *
+ * return float the calculated wave component
+ */
+static inline float bandlimited_sawtrianglepart(unsigned int start, unsigned int max_harmonics, t_bandlimited_phase p, int real) {
+	return bandlimited_trianglepart(start, max_harmonics, p, real) - bandlimited_sawwavepart(start, max_harmonics, p, real);
+}
+
+/*
+ * These functions calculate what has to be added to the nearest wavetable
+ * (see bandlimited_harmpos) to get exactly max_harmonics harmonics.
+ *
+ * param const t_bandlimited_tableset * table set
+ * param unsigned int maxium number of generated harmonics
+ * param float frequency in hz, unused
+ * param t_bandlimited_phase phase
+ *
+ * return float the correction to the wavetable lookup
+ */
+static inline float bandlimited_square_residual(const t_bandlimited_tableset *set, unsigned int max_harmonics, float freq, t_bandlimited_phase p) {
+	unsigned int nearest = set->levels[bandlimited_harmpos(set, max_harmonics) - 1];
+	
+	if(max_harmonics > nearest)
+		return bandlimited_squarepart(nearest+1, max_harmonics, p, 0);
+	else if(max_harmonics < nearest)
+		return -bandlimited_squarepart(max_harmonics+1, nearest, p, 0);
+	return 0.0f;
+}
+
+static inline float bandlimited_triangle_residual(const t_bandlimited_tableset *set, unsigned int max_harmonics, float freq, t_bandlimited_phase p) {
+	unsigned int nearest = set->levels[bandlimited_harmpos(set, max_harmonics) - 1];
+	
+	if(max_harmonics > nearest)
+		return bandlimited_trianglepart(nearest+1, max_harmonics, p, 0);
+	else if(max_harmonics < nearest)
+		return -bandlimited_trianglepart(max_harmonics+1, nearest, p, 0);
+	return 0.0f;
+}
+
+static inline float bandlimited_sawwave_residual(const t_bandlimited_tableset *set, unsigned int max_harmonics, float freq, t_bandlimited_phase p) {
+	unsigned int nearest = set->levels[bandlimited_harmpos(set, max_harmonics) - 1];
+	
+	if(max_harmonics > nearest)
+		return bandlimited_sawwavepart(nearest+1, max_harmonics, p, 0);
+	else if(max_harmonics < nearest)
+		return -bandlimited_sawwavepart(max_harmonics+1, nearest, p, 0);
+	return 0.0f;
+}
+
+static inline float bandlimited_sawtriangle_residual(const t_bandlimited_tableset *set, unsigned int max_harmonics, float freq, t_bandlimited_phase p) {
+	unsigned int nearest = set->levels[bandlimited_harmpos(set, max_harmonics) - 1];
+	
+	if(max_harmonics > nearest)
+		return bandlimited_sawtrianglepart(nearest+1, max_harmonics, p, 0);
+	else if(max_harmonics < nearest)
+		return -bandlimited_sawtrianglepart(max_harmonics+1, nearest, p, 0);
+	return 0.0f;
+}
+
+/*
+ * This function is bandlimited_sawwave_residual at phase p2 less at phase
+ * p, the correction to a pulse.
+ *
+ * param const t_bandlimited_tableset * table set
+ * param unsigned int maxium number of generated harmonics
+ * param float frequency in hz, unused
+ * param t_bandlimited_phase phase of the falling edge
+ * param t_bandlimited_phase phase of the rising edge
+ *
+ * return float the correction to the wavetable lookups
+ */
+static inline float bandlimited_pulse_residual(const t_bandlimited_tableset *set, unsigned int max_harmonics, float freq, t_bandlimited_phase p, t_bandlimited_phase p2) {
+	unsigned int nearest = set->levels[bandlimited_harmpos(set, max_harmonics) - 1];
+
+	if(max_harmonics > nearest)
+		return bandlimited_sawwavepartpair(nearest+1, max_harmonics, p, p2);
+	else if(max_harmonics < nearest)
+		return -bandlimited_sawwavepartpair(max_harmonics+1, nearest, p, p2);
+	return 0.0f;
+}
+
+/*
+ * In a table set for a band wider than the audible one (see
+ * bandlimited_dlayout) the level below max_harmonics already reaches
+ * BANDLIMITED_AUDIBLE, unless max_harmonics is held below the cutoff. These
+ * functions add the harmonics between that level and max_harmonics that
+ * are still heard, so it's only ever those that cost, and below the first
+ * level they take off the first wavetable's harmonics above max_harmonics.
+ *
+ * param const t_bandlimited_tableset * table set
+ * param unsigned int maxium number of generated harmonics
+ * param float frequency in hz
+ * param t_bandlimited_phase phase
+ *
+ * return float the correction to the wavetable lookup
+ */
+static inline float bandlimited_square_audible(const t_bandlimited_tableset *set, unsigned int max_harmonics, float freq, t_bandlimited_phase p) {
+	unsigned int below = set->levels[bandlimited_harmposfloor(set, max_harmonics) - 1];
+	float heard;
+
+	if(max_harmonics < below)
+		return -bandlimited_squarepart(max_harmonics+1, below, p, 0);
+	if(max_harmonics == below || below * freq >= BANDLIMITED_AUDIBLE)
+		return 0.0f;
+	heard = BANDLIMITED_AUDIBLE / freq;
+	if(heard < max_harmonics)
+		max_harmonics = (unsigned int)heard;
+	return max_harmonics > below ? bandlimited_squarepart(below+1, max_harmonics, p, 0) : 0.0f;
+}
+
+static inline float bandlimited_triangle_audible(const t_bandlimited_tableset *set, unsigned int max_harmonics, float freq, t_bandlimited_phase p) {
+	unsigned int below = set->levels[bandlimited_harmposfloor(set, max_harmonics) - 1];
+	float heard;
+
+	if(max_harmonics < below)
+		return -bandlimited_trianglepart(max_harmonics+1, below, p, 0);
+	if(max_harmonics == below || below * freq >= BANDLIMITED_AUDIBLE)
+		return 0.0f;
+	heard = BANDLIMITED_AUDIBLE / freq;
+	if(heard < max_harmonics)
+		max_harmonics = (unsigned int)heard;
+	return max_harmonics > below ? bandlimited_trianglepart(below+1, max_harmonics, p, 0) : 0.0f;
+}
+
+static inline float bandlimited_sawwave_audible(const t_bandlimited_tableset *set, unsigned int max_harmonics, float freq, t_bandlimited_phase p) {
+	unsigned int below = set->levels[bandlimited_harmposfloor(set, max_harmonics) - 1];
+	float heard;
+
+	if(max_harmonics < below)
+		return -bandlimited_sawwavepart(max_harmonics+1, below, p, 0);
+	if(max_harmonics == below || below * freq >= BANDLIMITED_AUDIBLE)
+		return 0.0f;
+	heard = BANDLIMITED_AUDIBLE / freq;
+	if(heard < max_harmonics)
+		max_harmonics = (unsigned int)heard;
+	return max_harmonics > below ? bandlimited_sawwavepart(below+1, max_harmonics, p, 0) : 0.0f;
+}
+
+static inline float bandlimited_sawtriangle_audible(const t_bandlimited_tableset *set, unsigned int max_harmonics, float freq, t_bandlimited_phase p) {
+	unsigned int below = set->levels[bandlimited_harmposfloor(set, max_harmonics) - 1];
+	float heard;
+
+	if(max_harmonics < below)
+		return -bandlimited_sawtrianglepart(max_harmonics+1, below, p, 0);
+	if(max_harmonics == below || below * freq >= BANDLIMITED_AUDIBLE)
+		return 0.0f;
+	heard = BANDLIMITED_AUDIBLE / freq;
+	if(heard < max_harmonics)
+		max_harmonics = (unsigned int)heard;
+	return max_harmonics > below ? bandlimited_sawtrianglepart(below+1, max_harmonics, p, 0) : 0.0f;
+}
+
+static inline float bandlimited_pulse_audible(const t_bandlimited_tableset *set, unsigned int max_harmonics, float freq, t_bandlimited_phase p, t_bandlimited_phase p2) {
+	unsigned int below = set->levels[bandlimited_harmposfloor(set, max_harmonics) - 1];
+	float heard;
+
+	if(max_harmonics < below)
+		return -bandlimited_sawwavepartpair(max_harmonics+1, below, p, p2);
+	if(max_harmonics == below || below * freq >= BANDLIMITED_AUDIBLE)
+		return 0.0f;
+	heard = BANDLIMITED_AUDIBLE / freq;
+	if(heard < max_harmonics)
+		max_harmonics = (unsigned int)heard;
+	return max_harmonics > below ? bandlimited_sawwavepartpair(below+1, max_harmonics, p, p2) : 0.0f;
+}
+
+/*
+ * Below the first level a crossfade has no wavetable under it to fade
+ * from, so these functions fade the harmonics in one at a time instead:
+ * they take off the first wavetable every harmonic above the number of
+ * harmonics, and the fraction of the top one that's left. A harmonic
+ * fades in as the number of harmonics goes from it to the next, so it's
+ * never above the cutoff and never more than a few of them are summed.
+ * The fade runs on one harmonic into the crossfade of the first two
+ * levels, where the first level's top harmonic fades in on top of it, so
+ * the two meet without a step. Only a maximum holding the number of
+ * harmonics makes the top one whole.
+ *
+ * param const t_bandlimited_tableset * table set
+ * param float number of harmonics, below the first level + 1
+ * param int 1 if the maximum holds the number of harmonics
+ * param t_bandlimited_phase phase
+ *
+ * return float the correction to the first wavetable, or to the crossfade
+ *				of the first two
+ */
+static inline float bandlimited_square_fade(const t_bandlimited_tableset *set, float harmonics, int held, t_bandlimited_phase p) {
+	unsigned int h = (unsigned int)harmonics;
+
+	if(h == 0)
+		return -bandlimited_squarepart(1, set->levels[0], p, 0);
+	return (held ? 1.0f : harmonics - h) * bandlimited_squarepart(h, h, p, 0) - bandlimited_squarepart(h, set->levels[0], p, 0);
+}
+
+static inline float bandlimited_triangle_fade(const t_bandlimited_tableset *set, float harmonics, int held, t_bandlimited_phase p) {
+	unsigned int h = (unsigned int)harmonics;
+
+	if(h == 0)
+		return -bandlimited_trianglepart(1, set->levels[0], p, 0);
+	return (held ? 1.0f : harmonics - h) * bandlimited_trianglepart(h, h, p, 0) - bandlimited_trianglepart(h, set->levels[0], p, 0);
+}
+
+static inline float bandlimited_sawwave_fade(const t_bandlimited_tableset *set, float harmonics, int held, t_bandlimited_phase p) {
+	unsigned int h = (unsigned int)harmonics;
+
+	if(h == 0)
+		return -bandlimited_sawwavepart(1, set->levels[0], p, 0);
+	return (held ? 1.0f : harmonics - h) * bandlimited_sawwavepart(h, h, p, 0) - bandlimited_sawwavepart(h, set->levels[0], p, 0);
+}
+
+static inline float bandlimited_sawtriangle_fade(const t_bandlimited_tableset *set, float harmonics, int held, t_bandlimited_phase p) {
+	unsigned int h = (unsigned int)harmonics;
+
+	if(h == 0)
+		return -bandlimited_sawtrianglepart(1, set->levels[0], p, 0);
+	return (held ? 1.0f : harmonics - h) * bandlimited_sawtrianglepart(h, h, p, 0) - bandlimited_sawtrianglepart(h, set->levels[0], p, 0);
+}
+
+static inline float bandlimited_pulse_fade(const t_bandlimited_tableset *set, float harmonics, int held, t_bandlimited_phase p, t_bandlimited_phase p2) {
+	unsigned int h = (unsigned int)harmonics;
+
+	if(h == 0)
+		return -bandlimited_sawwavepartpair(1, set->levels[0], p, p2);
+	return (held ? 1.0f : harmonics - h) * bandlimited_sawwavepartpair(h, h, p, p2) - bandlimited_sawwavepartpair(h, set->levels[0], p, p2);
+}
+
+/*
+ * Approximate waveforms use the wavetable below max_harmonics as is.
+ */
+static inline float bandlimited_noresidual(const t_bandlimited_tableset *set, unsigned int max_harmonics, float freq, t_bandlimited_phase p) {
+	return 0.0f;
+}
+
+static inline float bandlimited_pulse_noresidual(const t_bandlimited_tableset *set, unsigned int max_harmonics, float freq, t_bandlimited_phase p, t_bandlimited_phase p2) {
+	return 0.0f;
+}
+
+/*
+ * return float phase p wrapped to [0, 1)
+ */
+static inline float bandlimited_wrap(float p) {
+	p -= (float)(int)p;
+	return p < 0.0f ? p + 1.0f : p;
+}
+
+/*
+ * These functions give the polynomial bandlimited step (polyBLEP) and ramp
+ * (polyBLAMP) corrections around a discontinuity at phase 0: what has to be
+ * added to an upward step of 2, or to a corner where the slope goes up by
+ * 2 / dt, to smooth it over dt either side.
+ *
+ * param float phase, wrapped
+ * param float width of the correction as a fraction of the period
+ *
+ * return float the correction
+ */
+static inline float bandlimited_blep(float t, float dt) {
+	if(t < dt) {
+		t /= dt;
+		return t + t - t * t - 1.0f;
+	}
+	if(t > 1.0f - dt) {
+		t = (t - 1.0f) / dt;
+		return t * t + t + t + 1.0f;
+	}
+	return 0.0f;
+}
+
+static inline float bandlimited_blamp(float t, float dt) {
+	if(t < dt) {
+		t = t / dt - 1.0f;
+		return -t * t * t / 3.0f;
+	}
+	if(t > 1.0f - dt) {
+		t = (t - 1.0f) / dt + 1.0f;
+		return t * t * t / 3.0f;
+	}
+	return 0.0f;
+}
+
+/*
+ * Past the wavetables, when more harmonics are wanted than the top level
+ * of the table set has, summing the missing ones costs more the lower the frequency.
+ * These functions give each waveform as its naive shape corrected with
+ * polyBLEPs instead, at the same cost whatever the frequency. The
+ * corrections are half a period of the highest harmonic wide, so they
+ * follow the cutoff like the wavetables do.
+ *
+ * param float phase, wrapped
+ * param float number of harmonics
+ *
+ * return float the waveform, same sign as the wavetables
+ */
+static inline float bandlimited_sawwave_blep(float p, float harmonics) {
+	float dt = 0.5f / harmonics;
+
+	return 1.0f - 2.0f * p + bandlimited_blep(p, dt);
+}
+
+static inline float bandlimited_square_blep(float p, float harmonics) {
+	float dt = 0.5f / harmonics;
+
+	return (p < 0.5f ? 1.0f : -1.0f) + bandlimited_blep(p, dt) - bandlimited_blep(bandlimited_wrap(p + 0.5f), dt);
+}
+
+static inline float bandlimited_triangle_blep(float p, float harmonics) {
+	float dt = 0.5f / harmonics;
+	float q = bandlimited_wrap(p + 0.25f);
+
+	// corners at q = 0 and 1/2, where the slope turns by 8
+	return 1.0f - 4.0f * fabsf(q - 0.5f) + 4.0f * dt * (bandlimited_blamp(q, dt) - bandlimited_blamp(bandlimited_wrap(q + 0.5f), dt));
+}
+
+static inline float bandlimited_sawtriangle_blep(float p, float harmonics) {
+	return bandlimited_triangle_blep(p, harmonics) - bandlimited_sawwave_blep(p, harmonics);
+}
+
+
+/*
+ * These functions give the amplitude of harmonic h of each waveform, the
+ * same series the part functions above sum.
+ *
+ * param unsigned int harmonic
+ *
+ * return double amplitude of sin(2pi * h * p)
+ */
+static double bandlimited_sawwavecoef(unsigned int h) {
+	return 2.0 / (BANDLIMITED_PI * h);
+}
+
+static double bandlimited_squarecoef(unsigned int h) {
+	return h%2 == 1 ? 4.0 / (BANDLIMITED_PI * h) : 0;
+}
+
+static double bandlimited_trianglecoef(unsigned int h) {
+	return h%2 == 1 ? 8.0 * (h%4==3 ? -1 : 1) / (BANDLIMITED_PISQ * h * h) : 0;
+}
+
+static double bandlimited_sawtrianglecoef(unsigned int h) {
+	double t = h%2 == 1 ? (h%4==3 ? -1.0 : 1.0) / ((double)h * h) : 0;
+
+	return 2.0 * ((4.0 * t / BANDLIMITED_PI) - 1.0 / h) / BANDLIMITED_PI;
+}
+
+/* in cache order, see bandlimited_folds */
+static double (*const bandlimited_coefs[BANDLIMITED_CACHE_WAVES])(unsigned int) = {
+	bandlimited_sawwavecoef, bandlimited_trianglecoef, bandlimited_squarecoef, bandlimited_sawtrianglecoef
+};
+
+
+/*
+ * This function adds harmonics to a spectrum so that its inverse FFT is
+ * their sum of sines, in the real part or in the imaginary part.
+ * Harmonics past half the size wrap around.
+ *
+ * param double * real parts of the spectrum
+ * param double * imaginary parts of the spectrum
+ * param double (*)(unsigned int) amplitude of each harmonic
+ * param unsigned int first harmonic
+ * param unsigned int last harmonic
+ * param int 0 for the real part, 1 for the imaginary part
+ * param unsigned int size of the spectrum, a power of 2
+ *
+ */
+static void bandlimited_dspectrum(double *re, double *im, double (*coef)(unsigned int), unsigned int start, unsigned int max_harmonics, int imaginary,
+								  unsigned int size)
+{
+	unsigned int h, bin;
+	double amp;
+
+	for(h = start; h <= max_harmonics; h++) {
+		amp = coef(h) / 2;
+		bin = h % size;
+		// sin is (e^ix - e^-ix) / 2i, times i when it goes in the imaginary part
+		if(imaginary) {
+			re[bin] += amp;
+			re[(size - bin) % size] -= amp;
+		} else {
+			im[bin] -= amp;
+			im[(size - bin) % size] += amp;
+		}
+	}
+}
+
+/*
+ * Wavetables are shared by every oscillator on every thread. A table slot
+ * is filled once and doesn't change until the last reference is dropped,
+ * so reading one only has to see a finished table: an acquire load, which
+ * is a plain load on x86. Tables are written in place in the arena, so a
+ * pair of levels is claimed before it's built. A lazy build that finds the
+ * pair claimed by another thread doesn't wait for it, the level below
+ * stands in until it's published, see bandlimited_dmissing.
+ */
+static inline t_bandlimited_sample *bandlimited_slot(t_bandlimited_sample *const *slot) {
+	return __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+}
+
+static inline void bandlimited_publish(t_bandlimited_sample **slot, t_bandlimited_sample *t) {
+	__atomic_store_n(slot, t, __ATOMIC_RELEASE);
+}
+
+/*
+ * This function finds a wavetable in a table set laid out from base: every
+ * level of saw, then of triangle, square and sawtriangle, each table
+ * BANDLIMITED_TABSTRIDE bytes on from the last. Neighbouring levels of a
+ * waveform are next to each other, which is what a sweep or a crossfade
+ * reads. It's the layout of the arena and of the cache file alike.
+ *
+ * param const t_bandlimited_tableset * table set
+ * param const void * start of the arena or of the cached tables
+ * param int waveform, in cache order, see bandlimited_folds
+ * param unsigned int position of the wavetable
+ *
+ * return t_bandlimited_sample * where the wavetable goes
+ */
+static t_bandlimited_sample *bandlimited_dtableat(const t_bandlimited_tableset *set, const void *base, int wave, unsigned int pos) {
+	size_t offset = 0;
+	int w;
+
+	for(w = 0; w < wave; w++)
+		offset += set->nlevels * BANDLIMITED_TABSTRIDE(set->tabbits, bandlimited_folds[w]);
+	offset += pos * BANDLIMITED_TABSTRIDE(set->tabbits, bandlimited_folds[wave]);
+	return (t_bandlimited_sample *)((const char *)base + offset);
+}
+
+/*
+ * This function synthesises a pair of neighbouring wavetables of one
+ * waveform from their spectrum. Both tables are real, so the spectrum of
+ * one goes in as the real signal and the other as the imaginary one and a
+ * single inverse FFT gives both. They're written straight into the arena.
+ * If another thread has claimed the pair this one returns at once, unless
+ * it's told to wait, which is only done off the audio path. If there's no
+ * memory for the spectrum the claim is let go, the pair is tried again the
+ * next time it's missing. A set without an arena builds nothing.
+ *
+ * param t_bandlimited_tableset * table set
+ * param int waveform, in cache order, see bandlimited_folds
+ * param unsigned int position of either table of the pair, see bandlimited_dlayout
+ * param int 1 to wait for a pair another thread is building
+ *
+ * return int 1 if it built the pair, 0 if it didn't
+ */
+static int bandlimited_dmakewavepair(t_bandlimited_tableset *set, int wave, unsigned int pos, int wait)
+{
+	unsigned int max_harmonics, size = 1u << set->tabbits;
+	double *re, *im;
+	double (*coef)(unsigned int) = bandlimited_coefs[wave];
+	t_bandlimited_sample **table = set->tables[wave];
+	t_bandlimited_sample *first, *second = 0;
+	int i, k, len = BANDLIMITED_TABLEN(set->tabbits, bandlimited_folds[wave]);
+
+	if(!set->arena.data)
+		return 0;
+	pos -= pos % 2;
+	if(__atomic_exchange_n(&set->claimed[wave][pos/2], 1, __ATOMIC_ACQUIRE)) {
+		// the second level is published last
+		while(wait && !bandlimited_slot(&table[pos+1 < set->nlevels ? pos+1 : pos])
+			  && __atomic_load_n(&set->claimed[wave][pos/2], __ATOMIC_ACQUIRE))
+			bandlimited_yield();
+		return 0;
+	}
+	// the spectrum and the FFT's twiddles
+	re = (double *)calloc(3 * size, sizeof(double));
+	if(!re) {
+		__atomic_store_n(&set->claimed[wave][pos/2], 0, __ATOMIC_RELEASE);
+		return 0;
+	}
+	im = re + size;
+	max_harmonics = set->levels[pos];
+	first = bandlimited_dtableat(set, set->arena.data, wave, pos);
+	bandlimited_dspectrum(re, im, coef, 1, max_harmonics, 0, size);
+	if(pos+1 < set->nlevels) {
+		second = first + BANDLIMITED_TABSTRIDE(set->tabbits, bandlimited_folds[wave]) / sizeof(t_bandlimited_sample);
+		bandlimited_dspectrum(re, im, coef, 1, max_harmonics, 1, size);
+		bandlimited_dspectrum(re, im, coef, max_harmonics+1, set->levels[pos+1], 1, size);
+	}
+	bandlimited_ifft(re, im, im + size, size);
+
+	// table point i is the wave at phase (i-1)/size
+	for(i = 0; i < len; i++) {
+		k = (i + size - 1) % size;
+		first[i] = bandlimited_narrow(re[k]);
+		if(second)
+			second[i] = bandlimited_narrow(im[k]);
+	}
+	free(re);
+	bandlimited_publish(&table[pos], first);
+	if(second)
+		bandlimited_publish(&table[pos+1], second);
+	return 1;
+}
+
+/*
+ * Without a cache file the wavetables are built lazily: a waveform's first
+ * level when an oscillator starts using it, every other level the first
+ * time a lookup reaches it. A block only builds a few levels (the budget
+ * is per rendering thread) so a sweep doesn't stall the audio; until then the nearest level below stands in.
+ * It has fewer harmonics, so it sounds duller for a block but never aliases.
+ */
+static BANDLIMITED_TLS int bandlimited_lazybudget = 0;
+static uint64_t bandlimited_lazyns = 0;
+static unsigned int bandlimited_lazytables = 0;
+
+/*
+ * This function builds a pair of levels lazily, keeping count of how many
+ * and how long they took, see bandlimited_tables_lazytime.
+ */
+static void bandlimited_dlazypair(t_bandlimited_tableset *set, int wave, unsigned int pos, int wait)
+{
+	double start = bandlimited_clock();
+
+	if(!bandlimited_dmakewavepair(set, wave, pos, wait))
+		return;
+	__atomic_add_fetch(&bandlimited_lazyns, (uint64_t)(1e9 * (bandlimited_clock() - start)), __ATOMIC_RELAXED);
+	__atomic_add_fetch(&bandlimited_lazytables, pos - pos % 2 + 1 < set->nlevels ? 2 : 1, __ATOMIC_RELAXED);
+}
+
+/*
+ * What's read when not even a waveform's first level could be built, see
+ * bandlimited_dmissing: silence, as long as the longest wavetable.
+ */
+static const t_bandlimited_sample bandlimited_silence[BANDLIMITED_TABLEN(BANDLIMITED_MAXTABBITS, 1)]
+	__attribute__((aligned(BANDLIMITED_TABLEALIGN)));
+
+/*
+ * This function stands in for a wavetable that isn't there yet: it's built
+ * if the block's budget allows and nobody else is building it, otherwise
+ * the nearest level below that is there is read.
+ */
+static t_bandlimited_sample *bandlimited_dmissing(t_bandlimited_tableset *set, int wave, unsigned int pos)
+{
+	t_bandlimited_sample **table = set->tables[wave];
+	t_bandlimited_sample *t;
+
+	if(bandlimited_lazybudget > 0) {
+		bandlimited_lazybudget--;
+		bandlimited_dlazypair(set, wave, pos, 0);
+	}
+	while(!(t = bandlimited_slot(&table[pos])) && pos > 0)
+		pos--;
+	return t ? t : (t_bandlimited_sample *)bandlimited_silence;
+}
+
+/*
+ * This function returns a wavetable level, building it if needed.
+ *
+ * param t_bandlimited_tableset * table set
+ * param int waveform, in cache order, see bandlimited_folds
+ * param unsigned int position of the wavetable
+ *
+ * return t_bandlimited_sample * the wavetable, or the one standing in for it
+ */
+static inline t_bandlimited_sample *bandlimited_table(t_bandlimited_tableset *set, int wave, unsigned int pos)
+{
+	t_bandlimited_sample *t = bandlimited_slot(&set->tables[wave][pos]);
+
+	return t ? t : bandlimited_dmissing(set, wave, pos);
+}
+
+/*
+ * This function reads a block of samples with the table set's block
+ * reader (see bandlimited_read4_sized), from wavetables holding 1/fold of
+ * the period. Phases are wrapped and folded
+ * onto the stored part and the sign flipped where the wave is mirrored.
+ * Folding is exact in floats, so is the interpolation mirrored about the
+ * fold, and unfolded tables are read as they are.
+ *
+ * param const t_bandlimited_tableset * table set the wavetables are in
+ * param t_bandlimited_sample *const * pointer to the wavetable of each sample
+ * param const t_bandlimited_phase * phase of each sample
+ * param float * output buffer
+ * param int number of samples, up to BANDLIMITED_CHUNK
+ * param int how many times the period folds, see BANDLIMITED_SAWFOLD
+ */
+static inline void bandlimited_readfold(const t_bandlimited_tableset *set, t_bandlimited_sample *const *tab, const t_bandlimited_phase *phase, float *out, int n, int fold) {
+	t_bandlimited_phase folded[BANDLIMITED_CHUNK];
+	float flip[BANDLIMITED_CHUNK];
+	t_bandlimited_phase p;
+	int i;
+
+	if(fold == 1) {
+		set->read4(tab, phase, out, n);
+		return;
+	}
+	for(i = 0; i < n; i++) {
+		p = phase[i];
+		flip[i] = 1.0f;
+		if(fold == 2) {
+			// odd: f(1 - p) = -f(p)
+			if(p > BANDLIMITED_PHASEHALF) {
+				p = -p;
+				flip[i] = -1.0f;
+			}
+		} else {
+			// odd harmonics only: f(p + 1/2) = -f(p) and f(1/2 - p) = f(p)
+			if(p >= BANDLIMITED_PHASEHALF) {
+				p -= BANDLIMITED_PHASEHALF;
+				flip[i] = -1.0f;
+			}
+			if(p > BANDLIMITED_PHASEQUARTER)
+				p = BANDLIMITED_PHASEHALF - p;
+		}
+		folded[i] = p;
+	}
+	set->read4(tab, folded, out, n);
+	for(i = 0; i < n; i++)
+		out[i] *= flip[i];
+}
+
+
+/*
+ * This function runs the phasor for a chunk of samples, storing the phase
+ * and the number of harmonics of every sample. A frequency held for the
+ * whole chunk (a float on the inlet, or a held note) is divided into the
+ * cutoff once, and the caller can then pick its wavetables once too.
+ * Phases are fixed point so they wrap as they add up, a silent sample
+ * restarts the phasor at the first voice's offset, which is 0 unless
+ * bandlimited_unison_voices is rendering another voice through it.
+ *
+ * param t_bandlimited_osc* pointer to the oscillator
+ * param const float * frequency of each sample in hz
+ * param t_bandlimited_phase * phase of each sample
+ * param float * max number of harmonics of each sample, not rounded
+ * param int number of samples
+ *
+ * return int 1 if the frequency is the same, and above 0, all chunk long
+ */
+static inline int bandlimited_phasor(t_bandlimited_osc *x, const float *in, t_bandlimited_phase *phase, float *harmonics, int n) {
+	t_bandlimited_phase acc = x->phase[0], inc;
+	float f;
+	float conv = x->conv;
+	float cutoff = x->cutoff == 0? x->s_nq : x->cutoff;
+	float limit = x->max_harmonics;
+	int i;
+
+	f = in[0];
+	for(i = 1; i < n && in[i] == f; i++)
+		;
+	if(i == n && f > 0.0f) {
+		inc = bandlimited_fixphase(f * conv);
+		f = cutoff / f;
+		f = f < limit ? f : limit;
+		for(i = 0; i < n; i++) {
+			phase[i] = acc;
+			acc += inc;
+			harmonics[i] = f;
+		}
+		x->phase[0] = acc;
+		return 1;
+	}
+
+	for(i = 0; i < n; i++) {
+		f = in[i];
+		if(f > 0.0f) {
+			phase[i] = acc;
+			acc += bandlimited_fixphase(f * conv);
+			f = cutoff / f;
+			harmonics[i] = f < limit ? f : limit;
+		} else {
+			phase[i] = 0;
+			harmonics[i] = 0.0f;
+			acc = x->unison_offset[0];
+		}
+	}
+	x->phase[0] = acc;
+	return 0;
+}
+
+
+/*
+ * This function runs the phasor of one unison voice, see
+ * bandlimited_phasor. A silent sample restarts the voice at its offset.
+ *
+ * param t_bandlimited_phase * phase of the voice
+ * param t_bandlimited_phase phase the voice restarts at
+ * param const float * frequency of each sample in hz
+ * param float conversion from hz to phase increment, with the detune
+ * param t_bandlimited_phase * phase of each sample
+ * param int number of samples
+ */
+static inline void bandlimited_voicephasor(t_bandlimited_phase *ph, t_bandlimited_phase start, const float *in, float conv, t_bandlimited_phase *phase, int n) {
+	t_bandlimited_phase acc = *ph;
+	int i;
+
+	for(i = 0; i < n; i++) {
+		if(in[i] > 0.0f) {
+			phase[i] = acc;
+			acc += bandlimited_fixphase(in[i] * conv);
+		} else {
+			phase[i] = 0;
+			acc = start;
+		}
+	}
+	*ph = acc;
+}
+
+
+/*
+ * This function works out the number of harmonics of every sample of a
+ * chunk for the frequencies scaled by ratio, as bandlimited_phasor does.
+ *
+ * param t_bandlimited_osc* pointer to the oscillator
+ * param const float * frequency of each sample in hz
+ * param float ratio the frequencies are scaled by
+ * param float * max number of harmonics of each sample, not rounded
+ * param int number of samples
+ *
+ * return int 1 if the frequency is the same, and above 0, all chunk long
+ */
+static inline int bandlimited_harmonics(t_bandlimited_osc *x, const float *in, float ratio, float *harmonics, int n) {
+	float cutoff = x->cutoff == 0? x->s_nq : x->cutoff;
+	float limit = x->max_harmonics;
+	float f = in[0];
+	int i;
+
+	for(i = 1; i < n && in[i] == f; i++)
+		;
+	if(i == n && f > 0.0f) {
+		f = cutoff / (f * ratio);
+		f = f < limit ? f : limit;
+		for(i = 0; i < n; i++)
+			harmonics[i] = f;
+		return 1;
+	}
+	for(i = 0; i < n; i++) {
+		f = in[i] * ratio;
+		if(f > 0.0f) {
+			f = cutoff / f;
+			harmonics[i] = f < limit ? f : limit;
+		} else
+			harmonics[i] = 0.0f;
+	}
+	return 0;
+}
+
+
+/*
+ * This function points every sample of a chunk at the same wavetable.
+ *
+ * param t_bandlimited_sample ** wavetable of each sample
+ * param t_bandlimited_sample * the wavetable
+ * param int number of samples
+ */
+static inline void bandlimited_filltab(t_bandlimited_sample **tab, t_bandlimited_sample *t, int n) {
+	int i;
+
+	for(i = 0; i < n; i++)
+		tab[i] = t;
+}
+
+
+/*
+ * This function adds the wavetable picks of a chunk to the oscillator's
+ * statistics, see t_bandlimited_stats. A held frequency is counted once
+ * for the whole chunk. Otherwise every BANDLIMITED_STATSSTRIDE-th sample
+ * stands for the ones around it, which keeps the counts cheap enough to
+ * leave on with audio rate frequencies too. Silent samples aren't picks.
+ *
+ * param t_bandlimited_osc* pointer to the oscillator
+ * param const float * max number of harmonics of each sample, 0 if silent
+ * param int 1 if the number of harmonics is the same all chunk long
+ * param int number of samples
+ */
+static inline void bandlimited_countpicks(t_bandlimited_osc *x, const float *harmonics, int constant, int n) {
+	t_bandlimited_stats *s = &x->stats;
+	const t_bandlimited_tableset *set = x->set;
+	unsigned int h, pos, r, b;
+	int i, step = constant ? n : BANDLIMITED_STATSSTRIDE, w;
+
+	for(i = 0; i < n; i += step) {
+		if(harmonics[i] <= 0.0f)
+			continue;
+		w = n - i < step ? n - i : step;
+		s->picks += w;
+		if(harmonics[i] > set->reach) {
+			s->above += w;
+			continue;
+		}
+		h = (unsigned int)harmonics[i];
+		if(x->kernelmode != BANDLIMITED_EXACT) {
+			pos = bandlimited_harmposfloor(set, h) - 1;
+			// crossfades read the level above too
+			if(x->kernelmode == BANDLIMITED_CROSSFADE && pos + 1 < set->nlevels)
+				s->levels[(pos + 1) >> 5] |= 1u << ((pos + 1) & 31);
+		} else {
+			// wider bands correct from the level below up to what's heard,
+			// so there r is as many as it might add
+			pos = (set->band ? bandlimited_harmposfloor(set, h) : bandlimited_harmpos(set, h)) - 1;
+			r = h > set->levels[pos] ? h - set->levels[pos] : set->levels[pos] - h;
+			for(b = 0; r && b < BANDLIMITED_STATSBUCKETS - 1; b++)
+				r >>= 1;
+			s->residual[b] += w;
+		}
+		s->levels[pos >> 5] |= 1u << (pos & 31);
+	}
+}
+
+
+/*
+ * These macros expand to the block kernel of one waveform. A block is
+ * rendered in chunks: the phasor runs first, then every sample's table is
+ * looked up and counted (see bandlimited_countpicks), the tables are read
+ * with the table set's block reader and finally the exact correction (if any) is added. Samples that want more harmonics
+ * than the wavetables reach (see bandlimited_dlayout) come from the polyBLEP functions instead. There
+ * are no indirect calls in the loops and everything that only depends on
+ * the oscillator settings is worked out once per block.
+ *
+ * param kernel name of the kernel
+ * param wave waveform whose wavetables are read, BANDLIMITED_SAWTABLE...
+ * param fold how many times the period folds onto the tables
+ * param harmpos bandlimited_harmpos (exact) or bandlimited_harmposfloor (approximate, wider bands)
+ * param residual correction function, bandlimited_noresidual when approximate,
+ *		bandlimited_sawwave_audible... in wider bands
+ * param blep polyBLEP generator past the wavetables
+ * param sign 1 or -1
+ */
+#define BANDLIMITED_KERNEL(kernel, wave, fold, harmpos, residual, blep, sign)	\
+static void kernel(t_bandlimited_osc *x, const float *in, const float *dutycycle, float *out, int n) {	\
+	t_bandlimited_tableset *set = x->set;									\
+	float tabletop = set->reach;											\
+	t_bandlimited_phase phase[BANDLIMITED_CHUNK];								\
+	t_bandlimited_sample *tab[BANDLIMITED_CHUNK];								\
+	float harmonics[BANDLIMITED_CHUNK];									\
+	int i, m, c;																\
+																				\
+	for(; n > 0; n -= m, in += m, out += m) {									\
+		m = n < BANDLIMITED_CHUNK ? n : BANDLIMITED_CHUNK;						\
+		c = bandlimited_phasor(x, in, phase, harmonics, m);						\
+		bandlimited_countpicks(x, harmonics, c, m);								\
+		if(c)																	\
+			bandlimited_filltab(tab, bandlimited_table(set, wave, harmpos(set, (unsigned int)harmonics[0]) - 1), m);	\
+		else																	\
+			for(i = 0; i < m; i++)												\
+				tab[i] = bandlimited_table(set, wave, harmpos(set, (unsigned int)harmonics[i]) - 1);	\
+		bandlimited_readfold(set, tab, phase, out, m, fold);							\
+		for(i = 0; i < m; i++)													\
+			out[i] = in[i] > 0.0f ? (sign) * (harmonics[i] > tabletop ?	\
+				blep(bandlimited_floatphase(phase[i]), harmonics[i]) : out[i] + residual(set, (unsigned int)harmonics[i], in[i], phase[i])) : 0.0f;	\
+	}																			\
+}
+
+/*
+ * A pulse is the difference of two saws a duty cycle apart, see
+ * BANDLIMITED_KERNEL. Both saws read the same wavetable, picked once, and
+ * their exact corrections are summed together by the pulse residual.
+ */
+#define BANDLIMITED_PULSE_KERNEL(kernel, harmpos, residual)						\
+static void kernel(t_bandlimited_osc *x, const float *in, const float *dutycycle, float *out, int n) {	\
+	t_bandlimited_tableset *set = x->set;									\
+	float tabletop = set->reach;											\
+	t_bandlimited_phase phase[BANDLIMITED_CHUNK], phase2[BANDLIMITED_CHUNK];	\
+	float out2[BANDLIMITED_CHUNK], dc[BANDLIMITED_CHUNK];						\
+	t_bandlimited_sample *tab[BANDLIMITED_CHUNK];								\
+	float harmonics[BANDLIMITED_CHUNK];									\
+	int i, m, c;																\
+																				\
+	for(; n > 0; n -= m, in += m, out += m) {									\
+		m = n < BANDLIMITED_CHUNK ? n : BANDLIMITED_CHUNK;						\
+		c = bandlimited_phasor(x, in, phase, harmonics, m);						\
+		bandlimited_countpicks(x, harmonics, c, m);								\
+		if(c)																	\
+			bandlimited_filltab(tab, bandlimited_table(set, BANDLIMITED_SAWTABLE, harmpos(set, (unsigned int)harmonics[0]) - 1), m);	\
+		else																	\
+			for(i = 0; i < m; i++)												\
+				tab[i] = bandlimited_table(set, BANDLIMITED_SAWTABLE, harmpos(set, (unsigned int)harmonics[i]) - 1);	\
+		for(i = 0; i < m; i++) {												\
+			dc[i] = dutycycle ? dutycycle[i] : 0.5f;							\
+			phase2[i] = phase[i] + bandlimited_fixphase(dc[i]);					\
+		}																		\
+		if(dutycycle)															\
+			dutycycle += m;														\
+		bandlimited_readfold(set, tab, phase, out, m, BANDLIMITED_SAWFOLD);			\
+		bandlimited_readfold(set, tab, phase2, out2, m, BANDLIMITED_SAWFOLD);		\
+		for(i = 0; i < m; i++) {												\
+			if(in[i] <= 0.0f)													\
+				out[i] = 0.0f;													\
+			else if(harmonics[i] > tabletop)									\
+				out[i] = bandlimited_sawwave_blep(bandlimited_floatphase(phase2[i]), harmonics[i])	\
+					- bandlimited_sawwave_blep(bandlimited_floatphase(phase[i]), harmonics[i]) - 2.0f * (0.5f - dc[i]);	\
+			else																\
+				out[i] = (out2[i] - out[i]) + residual(set, (unsigned int)harmonics[i], in[i], phase[i], phase2[i])	\
+					- 2.0f * (0.5f - dc[i]);									\
+		}																		\
+	}																			\
+}
+
+/*
+ * Crossfaded kernels read the two wavetables around the number of harmonics
+ * and blend them by how far it is between the two, see
+ * bandlimited_harmposfrac. Sweeps don't step like the approximate kernels
+ * do and the cost is two table reads per sample whatever the frequency.
+ * Below the first level (and for one harmonic past it) the harmonics of
+ * the first wavetable are faded one by one instead, see
+ * bandlimited_sawwave_fade, whole only when the maximum holds them.
+ *
+ * param kernel name of the kernel
+ * param wave waveform whose wavetables are read, BANDLIMITED_SAWTABLE...
+ * param fold how many times the period folds onto the tables
+ * param fade correction up to the first level + 1
+ * param blep polyBLEP generator past the wavetables
+ * param sign 1 or -1
+ */
+#define BANDLIMITED_CROSSFADE_KERNEL(kernel, wave, fold, fade, blep, sign)		\
+static void kernel(t_bandlimited_osc *x, const float *in, const float *dutycycle, float *out, int n) {	\
+	t_bandlimited_tableset *set = x->set;									\
+	float tabletop = set->reach;											\
+	float faded = set->levels[0] + 1.0f;									\
+	float limit = x->max_harmonics;											\
+	t_bandlimited_phase phase[BANDLIMITED_CHUNK];								\
+	float harmonics[BANDLIMITED_CHUNK];											\
+	float weight[BANDLIMITED_CHUNK], above[BANDLIMITED_CHUNK];					\
+	t_bandlimited_sample *tab[BANDLIMITED_CHUNK], *tab2[BANDLIMITED_CHUNK];	\
+	unsigned int pos;															\
+	float w;																	\
+	int i, m, c;																\
+																				\
+	for(; n > 0; n -= m, in += m, out += m) {									\
+		m = n < BANDLIMITED_CHUNK ? n : BANDLIMITED_CHUNK;						\
+		c = bandlimited_phasor(x, in, phase, harmonics, m);						\
+		bandlimited_countpicks(x, harmonics, c, m);								\
+		if(c) {																	\
+			w = bandlimited_harmposfrac(set, harmonics[0], &pos);					\
+			bandlimited_filltab(tab, bandlimited_table(set, wave, pos - 1), m);	\
+			bandlimited_filltab(tab2, bandlimited_table(set, wave, pos), m);	\
+			for(i = 0; i < m; i++)												\
+				weight[i] = w;													\
+		} else																	\
+			for(i = 0; i < m; i++) {											\
+				weight[i] = bandlimited_harmposfrac(set, harmonics[i], &pos);		\
+				tab[i] = bandlimited_table(set, wave, pos - 1);		\
+				tab2[i] = bandlimited_table(set, wave, pos);			\
+			}																	\
+		bandlimited_readfold(set, tab, phase, out, m, fold);							\
+		bandlimited_readfold(set, tab2, phase, above, m, fold);						\
+		for(i = 0; i < m; i++)													\
+			out[i] = in[i] > 0.0f ? (sign) * (harmonics[i] > tabletop ?	\
+				blep(bandlimited_floatphase(phase[i]), harmonics[i]) : out[i] + weight[i] * (above[i] - out[i])	\
+				+ (harmonics[i] < faded ? fade(set, harmonics[i], harmonics[i] >= limit, phase[i]) : 0.0f)) : 0.0f;	\
+	}																			\
+}
+
+#define BANDLIMITED_PULSE_CROSSFADE_KERNEL(kernel)								\
+static void kernel(t_bandlimited_osc *x, const float *in, const float *dutycycle, float *out, int n) {	\
+	t_bandlimited_tableset *set = x->set;									\
+	float tabletop = set->reach;											\
+	float faded = set->levels[0] + 1.0f;									\
+	float limit = x->max_harmonics;											\
+	t_bandlimited_phase phase[BANDLIMITED_CHUNK], phase2[BANDLIMITED_CHUNK];	\
+	float harmonics[BANDLIMITED_CHUNK], weight[BANDLIMITED_CHUNK];				\
+	float above[BANDLIMITED_CHUNK], out2[BANDLIMITED_CHUNK];					\
+	float above2[BANDLIMITED_CHUNK], dc[BANDLIMITED_CHUNK];						\
+	t_bandlimited_sample *tab[BANDLIMITED_CHUNK], *tab2[BANDLIMITED_CHUNK];	\
+	unsigned int pos;															\
+	float w;																	\
+	int i, m, c;																\
+																				\
+	for(; n > 0; n -= m, in += m, out += m) {									\
+		m = n < BANDLIMITED_CHUNK ? n : BANDLIMITED_CHUNK;						\
+		c = bandlimited_phasor(x, in, phase, harmonics, m);						\
+		bandlimited_countpicks(x, harmonics, c, m);								\
+		if(c) {																	\
+			w = bandlimited_harmposfrac(set, harmonics[0], &pos);					\
+			bandlimited_filltab(tab, bandlimited_table(set, BANDLIMITED_SAWTABLE, pos - 1), m);	\
+			bandlimited_filltab(tab2, bandlimited_table(set, BANDLIMITED_SAWTABLE, pos), m);	\
+			for(i = 0; i < m; i++)												\
+				weight[i] = w;													\
+		} else																	\
+			for(i = 0; i < m; i++) {											\
+				weight[i] = bandlimited_harmposfrac(set, harmonics[i], &pos);		\
+				tab[i] = bandlimited_table(set, BANDLIMITED_SAWTABLE, pos - 1);	\
+				tab2[i] = bandlimited_table(set, BANDLIMITED_SAWTABLE, pos);	\
+			}																	\
+		for(i = 0; i < m; i++) {												\
+			dc[i] = dutycycle ? dutycycle[i] : 0.5f;							\
+			phase2[i] = phase[i] + bandlimited_fixphase(dc[i]);					\
+		}																		\
+		if(dutycycle)															\
+			dutycycle += m;														\
+		bandlimited_readfold(set, tab, phase, out, m, BANDLIMITED_SAWFOLD);			\
+		bandlimited_readfold(set, tab2, phase, above, m, BANDLIMITED_SAWFOLD);		\
+		bandlimited_readfold(set, tab, phase2, out2, m, BANDLIMITED_SAWFOLD);		\
+		bandlimited_readfold(set, tab2, phase2, above2, m, BANDLIMITED_SAWFOLD);		\
+		for(i = 0; i < m; i++) {												\
+			if(in[i] <= 0.0f)													\
+				out[i] = 0.0f;													\
+			else if(harmonics[i] > tabletop)									\
+				out[i] = bandlimited_sawwave_blep(bandlimited_floatphase(phase2[i]), harmonics[i])	\
+					- bandlimited_sawwave_blep(bandlimited_floatphase(phase[i]), harmonics[i]) - 2.0f * (0.5f - dc[i]);	\
+			else																\
+				out[i] = ((out2[i] + weight[i] * (above2[i] - out2[i])) - (out[i] + weight[i] * (above[i] - out[i])))	\
+					+ (harmonics[i] < faded ? bandlimited_pulse_fade(set, harmonics[i], harmonics[i] >= limit, phase[i], phase2[i]) : 0.0f)	\
+					- 2.0f * (0.5f - dc[i]);									\
+		}																		\
+	}																			\
+}
+
+/*
+ * Unison kernels render the stacked voices of an oscillator, see
+ * bandlimited_osc_setunison. The wavetables are picked once per sample for
+ * the whole stack, from its highest voice so that none of the voices
+ * alias, and every voice reads them at its own phase. Detuned voices all
+ * get the highest voice's number of harmonics, exact correction included.
+ *
+ * param kernel name of the kernel
+ * param wave waveform whose wavetables are read, BANDLIMITED_SAWTABLE...
+ * param fold how many times the period folds onto the tables
+ * param harmpos bandlimited_harmpos (exact) or bandlimited_harmposfloor (approximate, wider bands)
+ * param residual correction function, bandlimited_noresidual when approximate,
+ *		bandlimited_sawwave_audible... in wider bands
+ * param blep polyBLEP generator past the wavetables
+ * param sign 1 or -1
+ */
+#define BANDLIMITED_UNISON_KERNEL(kernel, wave, fold, harmpos, residual, blep, sign)	\
+static void kernel(t_bandlimited_osc *x, const float *in, float *out, int n) {	\
+	t_bandlimited_tableset *set = x->set;									\
+	float tabletop = set->reach;											\
+	t_bandlimited_phase phase[BANDLIMITED_CHUNK];								\
+	float harmonics[BANDLIMITED_CHUNK];											\
+	float voice[BANDLIMITED_CHUNK];												\
+	t_bandlimited_sample *tab[BANDLIMITED_CHUNK];								\
+	float top = x->unison_ratio[x->unison - 1];									\
+	float gain = (sign) * x->unison_gain;										\
+	int i, m, v, c;																\
+																				\
+	for(; n > 0; n -= m, in += m, out += m) {									\
+		m = n < BANDLIMITED_CHUNK ? n : BANDLIMITED_CHUNK;						\
+		c = bandlimited_harmonics(x, in, top, harmonics, m);					\
+		bandlimited_countpicks(x, harmonics, c, m);								\
+		if(c)																	\
+			bandlimited_filltab(tab, bandlimited_table(set, wave, harmpos(set, (unsigned int)harmonics[0]) - 1), m);	\
+		else																	\
+			for(i = 0; i < m; i++)												\
+				tab[i] = bandlimited_table(set, wave, harmpos(set, (unsigned int)harmonics[i]) - 1);	\
+		for(i = 0; i < m; i++)													\
+			out[i] = 0.0f;														\
+		for(v = 0; v < x->unison; v++) {										\
+			bandlimited_voicephasor(&x->phase[v], x->unison_offset[v], in, x->conv * x->unison_ratio[v], phase, m);	\
+			bandlimited_readfold(set, tab, phase, voice, m, fold);					\
+			for(i = 0; i < m; i++)												\
+				out[i] += in[i] <= 0.0f ? 0.0f : harmonics[i] > tabletop ?	\
+					blep(bandlimited_floatphase(phase[i]), harmonics[i]) : voice[i] + residual(set, (unsigned int)harmonics[i], top * in[i], phase[i]);	\
+		}																		\
+		for(i = 0; i < m; i++)													\
+			out[i] = in[i] > 0.0f ? gain * out[i] : 0.0f;						\
+	}																			\
+}
+
+BANDLIMITED_KERNEL(bandlimited_saw_kernel, BANDLIMITED_SAWTABLE, BANDLIMITED_SAWFOLD, bandlimited_harmpos, bandlimited_sawwave_residual, bandlimited_sawwave_blep, -1.0f)
+BANDLIMITED_KERNEL(bandlimited_saw_aprox_kernel, BANDLIMITED_SAWTABLE, BANDLIMITED_SAWFOLD, bandlimited_harmposfloor, bandlimited_noresidual, bandlimited_sawwave_blep, -1.0f)
+BANDLIMITED_KERNEL(bandlimited_rsaw_kernel, BANDLIMITED_SAWTABLE, BANDLIMITED_SAWFOLD, bandlimited_harmpos, bandlimited_sawwave_residual, bandlimited_sawwave_blep, 1.0f)
+BANDLIMITED_KERNEL(bandlimited_rsaw_aprox_kernel, BANDLIMITED_SAWTABLE, BANDLIMITED_SAWFOLD, bandlimited_harmposfloor, bandlimited_noresidual, bandlimited_sawwave_blep, 1.0f)
+BANDLIMITED_KERNEL(bandlimited_square_kernel, BANDLIMITED_SQUARETABLE, BANDLIMITED_SQUAREFOLD, bandlimited_harmpos, bandlimited_square_residual, bandlimited_square_blep, 1.0f)
+BANDLIMITED_KERNEL(bandlimited_square_aprox_kernel, BANDLIMITED_SQUARETABLE, BANDLIMITED_SQUAREFOLD, bandlimited_harmposfloor, bandlimited_noresidual, bandlimited_square_blep, 1.0f)
+BANDLIMITED_KERNEL(bandlimited_triangle_kernel, BANDLIMITED_TRIANGLETABLE, BANDLIMITED_TRIANGLEFOLD, bandlimited_harmpos, bandlimited_triangle_residual, bandlimited_triangle_blep, 1.0f)
+BANDLIMITED_KERNEL(bandlimited_triangle_aprox_kernel, BANDLIMITED_TRIANGLETABLE, BANDLIMITED_TRIANGLEFOLD, bandlimited_harmposfloor, bandlimited_noresidual, bandlimited_triangle_blep, 1.0f)
+BANDLIMITED_KERNEL(bandlimited_sawtriangle_kernel, BANDLIMITED_SAWTRIANGLETABLE, BANDLIMITED_SAWTRIANGLEFOLD, bandlimited_harmpos, bandlimited_sawtriangle_residual, bandlimited_sawtriangle_blep, 1.0f)
+BANDLIMITED_KERNEL(bandlimited_sawtriangle_aprox_kernel, BANDLIMITED_SAWTRIANGLETABLE, BANDLIMITED_SAWTRIANGLEFOLD, bandlimited_harmposfloor, bandlimited_noresidual, bandlimited_sawtriangle_blep, 1.0f)
+BANDLIMITED_PULSE_KERNEL(bandlimited_pulse_kernel, bandlimited_harmpos, bandlimited_pulse_residual)
+BANDLIMITED_PULSE_KERNEL(bandlimited_pulse_aprox_kernel, bandlimited_harmposfloor, bandlimited_pulse_noresidual)
+BANDLIMITED_KERNEL(bandlimited_saw_wide_kernel, BANDLIMITED_SAWTABLE, BANDLIMITED_SAWFOLD, bandlimited_harmposfloor, bandlimited_sawwave_audible, bandlimited_sawwave_blep, -1.0f)
+BANDLIMITED_KERNEL(bandlimited_rsaw_wide_kernel, BANDLIMITED_SAWTABLE, BANDLIMITED_SAWFOLD, bandlimited_harmposfloor, bandlimited_sawwave_audible, bandlimited_sawwave_blep, 1.0f)
+BANDLIMITED_KERNEL(bandlimited_square_wide_kernel, BANDLIMITED_SQUARETABLE, BANDLIMITED_SQUAREFOLD, bandlimited_harmposfloor, bandlimited_square_audible, bandlimited_square_blep, 1.0f)
+BANDLIMITED_KERNEL(bandlimited_triangle_wide_kernel, BANDLIMITED_TRIANGLETABLE, BANDLIMITED_TRIANGLEFOLD, bandlimited_harmposfloor, bandlimited_triangle_audible, bandlimited_triangle_blep, 1.0f)
+BANDLIMITED_KERNEL(bandlimited_sawtriangle_wide_kernel, BANDLIMITED_SAWTRIANGLETABLE, BANDLIMITED_SAWTRIANGLEFOLD, bandlimited_harmposfloor, bandlimited_sawtriangle_audible, bandlimited_sawtriangle_blep, 1.0f)
+BANDLIMITED_PULSE_KERNEL(bandlimited_pulse_wide_kernel, bandlimited_harmposfloor, bandlimited_pulse_audible)
+BANDLIMITED_CROSSFADE_KERNEL(bandlimited_saw_xfade_kernel, BANDLIMITED_SAWTABLE, BANDLIMITED_SAWFOLD, bandlimited_sawwave_fade, bandlimited_sawwave_blep, -1.0f)
+BANDLIMITED_CROSSFADE_KERNEL(bandlimited_rsaw_xfade_kernel, BANDLIMITED_SAWTABLE, BANDLIMITED_SAWFOLD, bandlimited_sawwave_fade, bandlimited_sawwave_blep, 1.0f)
+BANDLIMITED_CROSSFADE_KERNEL(bandlimited_square_xfade_kernel, BANDLIMITED_SQUARETABLE, BANDLIMITED_SQUAREFOLD, bandlimited_square_fade, bandlimited_square_blep, 1.0f)
+BANDLIMITED_CROSSFADE_KERNEL(bandlimited_triangle_xfade_kernel, BANDLIMITED_TRIANGLETABLE, BANDLIMITED_TRIANGLEFOLD, bandlimited_triangle_fade, bandlimited_triangle_blep, 1.0f)
+BANDLIMITED_CROSSFADE_KERNEL(bandlimited_sawtriangle_xfade_kernel, BANDLIMITED_SAWTRIANGLETABLE, BANDLIMITED_SAWTRIANGLEFOLD, bandlimited_sawtriangle_fade, bandlimited_sawtriangle_blep, 1.0f)
+BANDLIMITED_PULSE_CROSSFADE_KERNEL(bandlimited_pulse_xfade_kernel)
+BANDLIMITED_UNISON_KERNEL(bandlimited_saw_unison_kernel, BANDLIMITED_SAWTABLE, BANDLIMITED_SAWFOLD, bandlimited_harmpos, bandlimited_sawwave_residual, bandlimited_sawwave_blep, -1.0f)
+BANDLIMITED_UNISON_KERNEL(bandlimited_saw_aprox_unison_kernel, BANDLIMITED_SAWTABLE, BANDLIMITED_SAWFOLD, bandlimited_harmposfloor, bandlimited_noresidual, bandlimited_sawwave_blep, -1.0f)
+BANDLIMITED_UNISON_KERNEL(bandlimited_rsaw_unison_kernel, BANDLIMITED_SAWTABLE, BANDLIMITED_SAWFOLD, bandlimited_harmpos, bandlimited_sawwave_residual, bandlimited_sawwave_blep, 1.0f)
+BANDLIMITED_UNISON_KERNEL(bandlimited_rsaw_aprox_unison_kernel, BANDLIMITED_SAWTABLE, BANDLIMITED_SAWFOLD, bandlimited_harmposfloor, bandlimited_noresidual, bandlimited_sawwave_blep, 1.0f)
+BANDLIMITED_UNISON_KERNEL(bandlimited_square_unison_kernel, BANDLIMITED_SQUARETABLE, BANDLIMITED_SQUAREFOLD, bandlimited_harmpos, bandlimited_square_residual, bandlimited_square_blep, 1.0f)
+BANDLIMITED_UNISON_KERNEL(bandlimited_square_aprox_unison_kernel, BANDLIMITED_SQUARETABLE, BANDLIMITED_SQUAREFOLD, bandlimited_harmposfloor, bandlimited_noresidual, bandlimited_square_blep, 1.0f)
+BANDLIMITED_UNISON_KERNEL(bandlimited_triangle_unison_kernel, BANDLIMITED_TRIANGLETABLE, BANDLIMITED_TRIANGLEFOLD, bandlimited_harmpos, bandlimited_triangle_residual, bandlimited_triangle_blep, 1.0f)
+BANDLIMITED_UNISON_KERNEL(bandlimited_triangle_aprox_unison_kernel, BANDLIMITED_TRIANGLETABLE, BANDLIMITED_TRIANGLEFOLD, bandlimited_harmposfloor, bandlimited_noresidual, bandlimited_triangle_blep, 1.0f)
+BANDLIMITED_UNISON_KERNEL(bandlimited_sawtriangle_unison_kernel, BANDLIMITED_SAWTRIANGLETABLE, BANDLIMITED_SAWTRIANGLEFOLD, bandlimited_harmpos, bandlimited_sawtriangle_residual, bandlimited_sawtriangle_blep, 1.0f)
+BANDLIMITED_UNISON_KERNEL(bandlimited_sawtriangle_aprox_unison_kernel, BANDLIMITED_SAWTRIANGLETABLE, BANDLIMITED_SAWTRIANGLEFOLD, bandlimited_harmposfloor, bandlimited_noresidual, bandlimited_sawtriangle_blep, 1.0f)
+BANDLIMITED_UNISON_KERNEL(bandlimited_saw_wide_unison_kernel, BANDLIMITED_SAWTABLE, BANDLIMITED_SAWFOLD, bandlimited_harmposfloor, bandlimited_sawwave_audible, bandlimited_sawwave_blep, -1.0f)
+BANDLIMITED_UNISON_KERNEL(bandlimited_rsaw_wide_unison_kernel, BANDLIMITED_SAWTABLE, BANDLIMITED_SAWFOLD, bandlimited_harmposfloor, bandlimited_sawwave_audible, bandlimited_sawwave_blep, 1.0f)
+BANDLIMITED_UNISON_KERNEL(bandlimited_square_wide_unison_kernel, BANDLIMITED_SQUARETABLE, BANDLIMITED_SQUAREFOLD, bandlimited_harmposfloor, bandlimited_square_audible, bandlimited_square_blep, 1.0f)
+BANDLIMITED_UNISON_KERNEL(bandlimited_triangle_wide_unison_kernel, BANDLIMITED_TRIANGLETABLE, BANDLIMITED_TRIANGLEFOLD, bandlimited_harmposfloor, bandlimited_triangle_audible, bandlimited_triangle_blep, 1.0f)
+BANDLIMITED_UNISON_KERNEL(bandlimited_sawtriangle_wide_unison_kernel, BANDLIMITED_SAWTRIANGLETABLE, BANDLIMITED_SAWTRIANGLEFOLD, bandlimited_harmposfloor, bandlimited_sawtriangle_audible, bandlimited_sawtriangle_blep, 1.0f)
+
+/*
+ * Block kernels by waveform and mode.
+ */
+static void (*const bandlimited_kernels[][3])(t_bandlimited_osc *, const float *, const float *, float *, int) = {
+	{ &bandlimited_saw_kernel, &bandlimited_saw_aprox_kernel, &bandlimited_saw_xfade_kernel },
+	{ &bandlimited_rsaw_kernel, &bandlimited_rsaw_aprox_kernel, &bandlimited_rsaw_xfade_kernel },
+	{ &bandlimited_square_kernel, &bandlimited_square_aprox_kernel, &bandlimited_square_xfade_kernel },
+	{ &bandlimited_triangle_kernel, &bandlimited_triangle_aprox_kernel, &bandlimited_triangle_xfade_kernel },
+	{ &bandlimited_sawtriangle_kernel, &bandlimited_sawtriangle_aprox_kernel, &bandlimited_sawtriangle_xfade_kernel },
+	{ &bandlimited_pulse_kernel, &bandlimited_pulse_aprox_kernel, &bandlimited_pulse_xfade_kernel }
+};
+
+/*
+ * Unison kernels by waveform and mode. The rest stack their voices with
+ * the block kernels above, see bandlimited_unison_voices.
+ */
+static void (*const bandlimited_unison_kernels[][3])(t_bandlimited_osc *, const float *, float *, int) = {
+	{ &bandlimited_saw_unison_kernel, &bandlimited_saw_aprox_unison_kernel, 0 },
+	{ &bandlimited_rsaw_unison_kernel, &bandlimited_rsaw_aprox_unison_kernel, 0 },
+	{ &bandlimited_square_unison_kernel, &bandlimited_square_aprox_unison_kernel, 0 },
+	{ &bandlimited_triangle_unison_kernel, &bandlimited_triangle_aprox_unison_kernel, 0 },
+	{ &bandlimited_sawtriangle_unison_kernel, &bandlimited_sawtriangle_aprox_unison_kernel, 0 },
+	{ 0, 0, 0 }
+};
+
+/*
+ * Kernels of the exact and crossfaded modes in table sets for a band wider
+ * than the audible one, by waveform, see bandlimited_osc_settype.
+ */
+static void (*const bandlimited_wide_kernels[])(t_bandlimited_osc *, const float *, const float *, float *, int) = {
+	&bandlimited_saw_wide_kernel, &bandlimited_rsaw_wide_kernel, &bandlimited_square_wide_kernel,
+	&bandlimited_triangle_wide_kernel, &bandlimited_sawtriangle_wide_kernel, &bandlimited_pulse_wide_kernel
+};
+
+static void (*const bandlimited_wide_unison_kernels[])(t_bandlimited_osc *, const float *, float *, int) = {
+	&bandlimited_saw_wide_unison_kernel, &bandlimited_rsaw_wide_unison_kernel, &bandlimited_square_wide_unison_kernel,
+	&bandlimited_triangle_wide_unison_kernel, &bandlimited_sawtriangle_wide_unison_kernel, 0
+};
+
+/*
+ * This function renders the unison voices of waveforms and modes without a
+ * unison kernel, one voice after another through the block kernel.
+ *
+ * param t_bandlimited_osc* pointer to the oscillator
+ * param const float * frequency of each sample in hz
+ * param const float * duty cycle of each sample (pulse only), 0 for a constant 0.5
+ * param float * output buffer
+ * param int number of samples
+ */
+static void bandlimited_unison_voices(t_bandlimited_osc *x, const float *in, const float *dutycycle, float *out, int n) {
+	float scaled[BANDLIMITED_CHUNK], voice[BANDLIMITED_CHUNK];
+	t_bandlimited_phase first, offset = x->unison_offset[0];
+	int i, m, v;
+
+	for(; n > 0; n -= m, in += m, out += m) {
+		m = n < BANDLIMITED_CHUNK ? n : BANDLIMITED_CHUNK;
+		for(i = 0; i < m; i++)
+			out[i] = 0.0f;
+		// the block kernels run the first phase and restart it at the first
+		// offset after silence, every voice takes its turn there
+		first = x->phase[0];
+		for(v = 0; v < x->unison; v++) {
+			for(i = 0; i < m; i++)
+				scaled[i] = in[i] * x->unison_ratio[v];
+			x->phase[0] = v ? x->phase[v] : first;
+			x->unison_offset[0] = x->unison_offset[v];
+			x->kernel(x, scaled, dutycycle, voice, m);
+			if(v)
+				x->phase[v] = x->phase[0];
+			else
+				first = x->phase[0];
+			for(i = 0; i < m; i++)
+				out[i] += voice[i];
+		}
+		x->phase[0] = first;
+		x->unison_offset[0] = offset;
+		if(dutycycle)
+			dutycycle += m;
+		for(i = 0; i < m; i++)
+			out[i] *= x->unison_gain;
+	}
+}
+
+
+/*
+ * This function generates the sin(2pi * x) wavetable.
+ *
+ */
+static void bandlimited_dmaketable(void)
+{
+    int i;
+    float *fp, phase, phsinc = (2.0f * BANDLIMITED_PI) / BANDLIMITED_TABSIZE;
+    
+    if (bandlimited_sin_made) return;
+    bandlimited_sin_made = 1;
+    for (i = BANDLIMITED_TABSIZE+3, fp = (bandlimited_sin_table), phase = -phsinc; i--;
+		 fp++, phase += phsinc)
+		*fp = sin(phase);
+
+}
+
+/*
+ * Wavetable generation is spread over worker threads, one job per pair of
+ * levels of a waveform, see bandlimited_dmakewavepair.
+ */
+typedef struct _bandlimited_gen
+	{
+		t_bandlimited_tableset *set;
+		int wave;
+	} t_bandlimited_gen;
+
+static void bandlimited_dmakewavejob(void *arg, int job)
+{
+	t_bandlimited_gen *gen = (t_bandlimited_gen *)arg;
+
+	bandlimited_dmakewavepair(gen->set, gen->wave, job * 2, 1);
+}
+
+/*
+ * This function spaces the harmonic levels: BANDLIMITED_INCREMENT apart at
+ * first, then ratio apart once that's the wider step, up to top. A ratio
+ * of 1 gives one level every BANDLIMITED_INCREMENT harmonics.
+ *
+ * param double ratio between neighbouring levels
+ * param unsigned int * where the harmonics of each level are stored,
+ *						room for BANDLIMITED_HAMSIZE levels
+ * param unsigned int harmonics of the last level, up to BANDLIMITED_TOPHARMONICS
+ *
+ * return unsigned int number of levels
+ */
+static unsigned int bandlimited_dspacelevels(double ratio, unsigned int *levels, unsigned int top) {
+	unsigned int n = 0, h = BANDLIMITED_INCREMENT, next;
+
+	for(;;) {
+		levels[n++] = h;
+		if(h >= top)
+			return n;
+		next = (unsigned int)(h * ratio);
+		if(next < h + BANDLIMITED_INCREMENT)
+			next = h + BANDLIMITED_INCREMENT;
+		h = next < top ? next : top;
+	}
+}
+
+/*
+ * return size_t bytes the wavetables of one harmonic level take in the
+ * arena, with 2^tabbits points
+ */
+static size_t bandlimited_levelsize(int tabbits) {
+	size_t size = 0;
+	int i;
+
+	for(i = 0; i < BANDLIMITED_CACHE_WAVES; i++)
+		size += BANDLIMITED_TABSTRIDE(tabbits, bandlimited_folds[i]);
+	return size;
+}
+
+/*
+ * This function works out which table set serves an oscillator: the half
+ * octaves the top of its band (the cutoff, or nyquist) is above
+ * BANDLIMITED_AUDIBLE. Rates up to 44.1 and 48 khz are band 0, 88.2 and
+ * 96 khz are band 2, 176.4 and 192 khz band 4.
+ *
+ * param float sample rate in hz
+ * param float cutoff frequency, 0 for the nyquist limit
+ *
+ * return unsigned int band, below BANDLIMITED_MAXBANDS
+ */
+static unsigned int bandlimited_band(float sr, float cutoff) {
+#if BANDLIMITED_AUDIBLE > 0
+	double top = cutoff > 0.0f ? cutoff : sr / 2.0;
+	int band;
+
+	if(top <= BANDLIMITED_AUDIBLE)
+		return 0;
+	band = (int)floor(2.0 * log2(top / BANDLIMITED_AUDIBLE));
+	return band < BANDLIMITED_MAXBANDS ? band : BANDLIMITED_MAXBANDS - 1;
+#else
+	return 0;
+#endif
+}
+
+/*
+ * This function lays out the harmonic levels of a table set for the memory
+ * budget. With no budget, or a big enough one, there's a level every
+ * BANDLIMITED_INCREMENT harmonics. Otherwise the levels are as many as the
+ * budget holds: dense where few harmonics are, where every one of them is
+ * heard, and geometric above that, with the smallest ratio that fits.
+ * Sets for a band above the audible one are spaced by at least as much as
+ * the band is wider, so the level below any number of harmonics still
+ * reaches BANDLIMITED_AUDIBLE and there's no point in having the ones in
+ * between. For the same reason the top level serves as many times more
+ * harmonics as the band is wider, down to the lowest frequency it still
+ * covers the audible band for. Wavetables smaller than BANDLIMITED_TABSIZE
+ * top out at proportionally fewer harmonics, past them the polyBLEPs take over.
+ * It then fills in the lookup tables so finding a level is O(1).
+ *
+ * param t_bandlimited_tableset * table set, its band and size already set
+ */
+static void bandlimited_dlayout(t_bandlimited_tableset *set) {
+	size_t level = bandlimited_levelsize(set->tabbits);
+	unsigned int n = BANDLIMITED_HAMSIZE, h, below;
+	double low = 1.0, high = 1.0, ratio;
+	int i;
+
+	set->top = set->tabbits < BANDLIMITED_TABBITS ? BANDLIMITED_TOPHARMONICS >> (BANDLIMITED_TABBITS - set->tabbits) : BANDLIMITED_TOPHARMONICS;
+	if(bandlimited_budget && bandlimited_budget / level < BANDLIMITED_HAMSIZE)
+		n = bandlimited_budget / level < 2 ? 2 : bandlimited_budget / level;
+	if(n < BANDLIMITED_HAMSIZE) {
+		for(i = 0, high = BANDLIMITED_TOPHARMONICS; i < 64; i++) {
+			ratio = (low + high) / 2;
+			if(bandlimited_dspacelevels(ratio, set->levels, set->top) > n)
+				low = ratio;
+			else
+				high = ratio;
+		}
+	}
+	ratio = pow(2.0, set->band / 2.0);
+	set->nlevels = bandlimited_dspacelevels(high > ratio ? high : ratio, set->levels, set->top);
+	set->reach = (unsigned int)(set->top * ratio);
+	for(h = 0; h + 1 < set->nlevels; h++)
+		set->levelspan[h] = 1.0f / (set->levels[h+1] - set->levels[h]);
+
+	for(h = 0, below = 0; h <= BANDLIMITED_TOPHARMONICS; h++) {
+		while(below < set->nlevels && set->levels[below] <= h)
+			below++;
+		set->levelfloor[h] = below ? below : 1;
+		if(below == 0)
+			set->levelnearest[h] = 1;
+		else if(below == set->nlevels)
+			set->levelnearest[h] = below;
+		else if(h - set->levels[below-1] != set->levels[below] - h)
+			set->levelnearest[h] = h - set->levels[below-1] < set->levels[below] - h ? below : below+1;
+		else
+			/* halfway, like rint() round to the even position */
+			set->levelnearest[h] = below % 2 == 0 ? below : below+1;
+	}
+}
+
+/*
+ * This function allocates the list of levels of every waveform of a
+ * table set and the arena they're built in (see bandlimited_dtableat).
+ * The arena is only touched as levels are built or copied in, the
+ * waveforms read from a mapped cache file never touch it. A set without
+ * an arena still works: nothing is built in it, what isn't in a mapped
+ * cache file reads as silence, see bandlimited_dmissing.
+ *
+ * param t_bandlimited_tableset * table set
+ *
+ * return int 0 on sucess, 1 if there's no memory for the lists
+ */
+static int bandlimited_dallocalltables(t_bandlimited_tableset *set) {
+	int w;
+
+	for(w = 0; w < BANDLIMITED_CACHE_WAVES; w++)
+		if(!(set->tables[w] = (t_bandlimited_sample **)calloc(set->nlevels, sizeof(t_bandlimited_sample *))))
+			return 1;
+	if(bandlimited_arena_alloc(&set->arena, set->nlevels * bandlimited_levelsize(set->tabbits), bandlimited_hugepages))
+		set->arena.data = 0;
+	return 0;
+}
+
+/*
+ * This function builds every level of one waveform of a table set that
+ * isn't there yet, see bandlimited_dcachewave.
+ *
+ * param t_bandlimited_tableset * table set
+ * param int waveform, in cache order, see bandlimited_folds
+ *
+ * return int number of threads that built them
+ */
+static int bandlimited_dmakewave(t_bandlimited_tableset *set, int wave) {
+	t_bandlimited_gen gen;
+
+	gen.set = set;
+	gen.wave = wave;
+	return bandlimited_parallel((set->nlevels+1) / 2, &bandlimited_dmakewavejob, &gen);
+}
+
+/*
+ * This function clears up the memory used by the wavetables of a table
+ * set, and the set.
+ *
+ * param t_bandlimited_tableset * table set
+ */
+static void bandlimited_dfreealltables(t_bandlimited_tableset *set) {
+	int w;
+
+	for(w = 0; w < BANDLIMITED_CACHE_WAVES; w++)
+		free(set->tables[w]);
+	bandlimited_arena_free(&set->arena);
+	if(set->cache.data)
+		bandlimited_cache_unload(&set->cache);
+	free(set);
+}
+
+/*
+ * This function fills in what the wavetables of a table set depend on,
+ * see bandlimited_cache.h
+ *
+ */
+static void bandlimited_cachekey(const t_bandlimited_tableset *set, t_bandlimited_cachekey *key) {
+	unsigned int i;
+
+	memset(key, 0, sizeof(*key));
+	key->tabsize = 1u << set->tabbits;
+	key->increment = BANDLIMITED_INCREMENT;
+	key->hamsize = set->nlevels;
+	key->waves = (1 << BANDLIMITED_CACHE_WAVES) - 1;
+	key->samplesize = sizeof(t_bandlimited_sample);
+	key->format = BANDLIMITED_FORMAT;
+	key->folds = BANDLIMITED_SAWFOLD | BANDLIMITED_TRIANGLEFOLD << 8 | BANDLIMITED_SQUAREFOLD << 16 | BANDLIMITED_SAWTRIANGLEFOLD << 24;
+	// FNV-1a of the harmonics of every level
+	for(i = 0, key->layout = 2166136261u; i < set->nlevels; i++)
+		key->layout = (key->layout ^ set->levels[i]) * 16777619u;
+	key->one = 1.0f;
+}
+
+/*
+ * This function works out the cache file of a table set: the one set with
+ * bandlimited_tables_setcache or one named after the layout in the cache
+ * directory. Sets of a wider band get -b and the band appended, the
+ * set cache file also gets -s and the table size if it isn't the default.
+ *
+ * param t_bandlimited_tableset * table set
+ */
+static void bandlimited_cachefile(t_bandlimited_tableset *set) {
+	char name[64], suffix[16] = "";
+	int len = 0;
+
+	if(bandlimited_cacheset) {
+		if(set->tabbits != BANDLIMITED_TABBITS)
+			len = snprintf(suffix, sizeof(suffix), "-s%d", 1 << set->tabbits);
+		if(set->band)
+			snprintf(suffix + len, sizeof(suffix) - len, "-b%u", set->band);
+		if(!bandlimited_cachepath[0] || snprintf(set->cachefile, sizeof(set->cachefile), "%s%s",
+												 bandlimited_cachepath, suffix) >= (int)sizeof(set->cachefile))
+			set->cachefile[0] = 0;
+		return;
+	}
+	if(set->band)
+		snprintf(suffix, sizeof(suffix), "-b%u", set->band);
+	snprintf(name, sizeof(name), BANDLIMITED_CACHE_NAME, 1 << set->tabbits, BANDLIMITED_INCREMENT, set->nlevels, suffix);
+	if(bandlimited_cache_path(set->cachefile, sizeof(set->cachefile), name))
+		set->cachefile[0] = 0;
+}
+
+/*
+ * This function points the wavetables of the waveforms in a table set's
+ * cache file into it, if there's a valid one. Each waveform's levels are
+ * laid out in the file as in the arena, so where it's mapped the tables
+ * are read from the mapping as they are. With huge pages, or where it
+ * can't be mapped, they're copied into the arena.
+ *
+ * param t_bandlimited_tableset * table set, its lists and arena allocated
+ *
+ * return int 0 on sucess, 1 if there was nothing to load
+ */
+static int bandlimited_dloadalltables(t_bandlimited_tableset *set) {
+	t_bandlimited_cachekey key;
+	size_t stride, bytes[BANDLIMITED_CACHE_WAVES];
+	const char *base;
+	char *first;
+	uint32_t waves;
+	unsigned int i;
+	int w, copy;
+
+	if(!set->cachefile[0])
+		return 1;
+	
+	bandlimited_cachekey(set, &key);
+	for(w = 0; w < BANDLIMITED_CACHE_WAVES; w++)
+		bytes[w] = set->nlevels * BANDLIMITED_TABSTRIDE(set->tabbits, bandlimited_folds[w]);
+	if(bandlimited_cache_load(&set->cache, set->cachefile, &key, bytes, &waves))
+		return 1;
+
+	copy = bandlimited_hugepages || !set->cache.mapped;
+	if(copy && !set->arena.data) {
+		// nowhere to copy it to, the mapping will do
+		if(!set->cache.mapped) {
+			bandlimited_cache_unload(&set->cache);
+			return 1;
+		}
+		copy = 0;
+	}
+	base = (const char *)bandlimited_cache_tables(&set->cache);
+	for(w = 0; w < BANDLIMITED_CACHE_WAVES; w++) {
+		if(!(waves & (1u << w)))
+			continue;
+		first = (char *)base;
+		if(copy) {
+			first = (char *)bandlimited_dtableat(set, set->arena.data, w, 0);
+			memcpy(first, base, bytes[w]);
+		}
+		stride = BANDLIMITED_TABSTRIDE(set->tabbits, bandlimited_folds[w]);
+		for(i = 0; i < set->nlevels; i++)
+			set->tables[w][i] = (t_bandlimited_sample *)(first + i * stride);
+		base += bytes[w];
+	}
+	if(copy)
+		bandlimited_cache_unload(&set->cache);
+	set->cached = waves;
+	return 0;
+}
+
+/*
+ * This function writes every waveform of a table set that has all its
+ * levels to the cache file, one after the other, padding and all. The
+ * ones no oscillator has used aren't there. The sin table is quick to
+ * make and isn't cached.
+ *
+ * param t_bandlimited_tableset * table set
+ */
+static void bandlimited_dsavealltables(t_bandlimited_tableset *set) {
+	t_bandlimited_cachekey key;
+	const void *tables[BANDLIMITED_CACHE_WAVES];
+	size_t sizes[BANDLIMITED_CACHE_WAVES];
+	int w, n = 0;
+	
+	if(!set->cachefile[0])
+		return;
+	bandlimited_cachekey(set, &key);
+	key.waves = set->cached;
+	for(w = 0; w < BANDLIMITED_CACHE_WAVES; w++)
+		if(set->cached & (1u << w)) {
+			tables[n] = set->tables[w][0];
+			sizes[n++] = set->nlevels * BANDLIMITED_TABSTRIDE(set->tabbits, bandlimited_folds[w]);
+		}
+	bandlimited_cache_save(set->cachefile, &key, tables, sizes, n);
+}
+
+/*
+ * This function builds every level of a waveform of a table set that has a
+ * cache file, on as many threads as there are processors, and writes it to
+ * the cache file along with the other waveforms there. The levels are
+ * claimed pair by pair (see bandlimited_dmakewavepair), so oscillators
+ * building them lazily meanwhile are fine; only marking the waveform
+ * cached and writing the file take the lock.
+ *
+ * param t_bandlimited_tableset * table set
+ * param int waveform, in cache order, see bandlimited_folds
+ *
+ * return int 1 if the waveform was built, 0 if it was there already or
+ *				a level couldn't be
+ */
+static int bandlimited_dcachewave(t_bandlimited_tableset *set, int wave) {
+	double start = bandlimited_clock();
+	unsigned int i;
+	int threads, built = 0;
+
+	threads = bandlimited_dmakewave(set, wave);
+	for(i = 0; i < set->nlevels && bandlimited_slot(&set->tables[wave][i]); i++)
+		;
+	bandlimited_lock();
+	// a level left out for want of memory is tried again the next time the waveform is picked
+	if(i == set->nlevels && !(set->cached & (1u << wave))) {
+		__atomic_or_fetch(&set->cached, 1u << wave, __ATOMIC_RELEASE);
+		bandlimited_dsavealltables(set);
+		built = 1;
+	}
+	set->time += bandlimited_clock() - start;
+	if(threads > set->threads)
+		set->threads = threads;
+	bandlimited_unlock();
+	return built;
+}
+
+/* waveforms being built for cache files on worker threads, see bandlimited_tables_wait */
+static long bandlimited_background = 0;
+
+/*
+ * This function is the worker thread building a waveform for its cache
+ * file. It drops the reference on the tables that kept its set alive.
+ */
+static void bandlimited_dcachejob(void *arg) {
+	t_bandlimited_gen *gen = (t_bandlimited_gen *)arg;
+	t_bandlimited_tableset *set = gen->set;
+	int wave = gen->wave;
+
+	free(gen);
+	bandlimited_dcachewave(set, wave);
+	__atomic_and_fetch(&set->building, ~(1u << wave), __ATOMIC_RELEASE);
+	bandlimited_tables_free();
+	__atomic_sub_fetch(&bandlimited_background, 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * This function starts building a waveform of a table set that has a
+ * cache file the first time an oscillator picks it, see
+ * bandlimited_dcachewave. It runs on a worker thread so picking a waveform
+ * never holds up the caller for the whole build; until it's done the
+ * levels read are built lazily, see bandlimited_dmissing. The worker holds
+ * a reference on the tables, which keeps the set around until it's done.
+ * Where there are no threads it's built there and then. Only the waveforms
+ * oscillators use are ever built.
+ *
+ * param t_bandlimited_tableset * table set
+ * param int waveform, in cache order, see bandlimited_folds
+ *
+ * return int 1 if a build was started, 0 if the waveform is there, on its
+ *				way or can't be built
+ */
+static int bandlimited_dcachelater(t_bandlimited_tableset *set, int wave) {
+	unsigned int bit = 1u << wave;
+	t_bandlimited_gen *gen;
+
+	if((__atomic_load_n(&set->cached, __ATOMIC_ACQUIRE) & bit) || !set->arena.data
+	   || (__atomic_fetch_or(&set->building, bit, __ATOMIC_ACQ_REL) & bit))
+		return 0;
+	if(!(gen = (t_bandlimited_gen *)malloc(sizeof(t_bandlimited_gen)))) {
+		__atomic_and_fetch(&set->building, ~bit, __ATOMIC_RELEASE);
+		return 0;
+	}
+	gen->set = set;
+	gen->wave = wave;
+	bandlimited_tables_new();
+	__atomic_add_fetch(&bandlimited_background, 1, __ATOMIC_ACQ_REL);
+	if(bandlimited_detach(&bandlimited_dcachejob, gen))
+		bandlimited_dcachejob(gen);
+	return 1;
+}
+
+/*
+ * This function waits for the waveforms being built for cache files on
+ * worker threads, see bandlimited_dcachelater. Oscillators never need
+ * to, it's for hosts that time the tables or are about to exit.
+ */
+void bandlimited_tables_wait(void) {
+	while(__atomic_load_n(&bandlimited_background, __ATOMIC_ACQUIRE))
+		bandlimited_yield();
+}
+
+/*
+ * This function sets the wavetable cache file. It only has an effect on
+ * table sets created afterwards, sets of a wider band than the audible
+ * one or another table size get them appended, see bandlimited_cachefile.
+ *
+ * param const char * path of the cache file, 0 or empty to not use a cache
+ */
+void bandlimited_tables_setcache(const char *path) {
+	bandlimited_lock();
+	bandlimited_cacheset = 1;
+	if(path && strlen(path) < sizeof(bandlimited_cachepath))
+		strcpy(bandlimited_cachepath, path);
+	else
+		bandlimited_cachepath[0] = 0;
+	bandlimited_unlock();
+}
+
+/*
+ * This function sets how much memory the wavetables may use, which decides
+ * how many harmonic levels each table set has (see bandlimited_dlayout).
+ * It only has an effect before the tables are created. Otherwise the budget comes
+ * from the BANDLIMITED_BUDGET environment variable, in bytes or with a k or
+ * M suffix, or from the BANDLIMITED_BUDGET compile time flag.
+ *
+ * param size_t bytes, 0 for a level every BANDLIMITED_INCREMENT harmonics
+ */
+void bandlimited_tables_setbudget(size_t bytes) {
+	bandlimited_lock();
+	bandlimited_budgetset = 1;
+	bandlimited_budget = bytes;
+	bandlimited_unlock();
+}
+
+/*
+ * This function sets whether the arenas of table sets created afterwards
+ * are backed by huge pages, see bandlimited_arena_alloc. Otherwise it
+ * comes from the BANDLIMITED_HUGEPAGES environment variable or compile
+ * time flag. Huge pages help patches with many voices over a wide range,
+ * which read from all over the tables; a set of 2048 point float tables
+ * takes a couple of them instead of around a thousand pages. Tables loaded
+ * from the cache are copied rather than mapped to get them.
+ *
+ * param int 0 for normal pages, 1 for transparent huge pages, 2 for
+ *			 explicit ones where there are any
+ */
+void bandlimited_tables_sethugepages(int huge) {
+	bandlimited_lock();
+	bandlimited_hugepagesset = 1;
+	bandlimited_hugepages = huge;
+	bandlimited_unlock();
+}
+
+/*
+ * return unsigned int number of harmonic levels of each waveform in the set
+ */
+unsigned int bandlimited_tableset_levels(const t_bandlimited_tableset *set) {
+	return set->nlevels;
+}
+
+/*
+ * return const char * the set's cache file, empty if there's none
+ */
+const char *bandlimited_tableset_cachefile(const t_bandlimited_tableset *set) {
+	return set->cachefile;
+}
+
+/*
+ * This function tells how long creating a table set took to load or build
+ * its wavetables.
+ *
+ * param const t_bandlimited_tableset * table set
+ * param int * where the number of threads that built them is stored,
+ *				0 if they were loaded. May be NULL
+ *
+ * return double seconds
+ */
+double bandlimited_tableset_time(const t_bandlimited_tableset *set, int *threads) {
+	double time;
+
+	// a worker thread may be adding to them, see bandlimited_dcachewave
+	bandlimited_lock();
+	if(threads)
+		*threads = set->threads;
+	time = set->time;
+	bandlimited_unlock();
+	return time;
+}
+
+/*
+ * return int the huge pages the set's wavetables are on, see
+ * bandlimited_tables_sethugepages, 0 if they aren't
+ */
+int bandlimited_tableset_hugepages(const t_bandlimited_tableset *set) {
+	return set->arena.huge;
+}
+
+/*
+ * This function creates the table set of a band and table size and loads
+ * what its cache file has. Nothing is built yet: with a cache file the
+ * waveforms missing from it are built whole as oscillators pick them (see
+ * bandlimited_dcachewave), without one level by level as they're read
+ * (see bandlimited_dmissing). It's called with the lock held.
+ *
+ * param unsigned int band, see bandlimited_band
+ * param int log2 of the wavetable size
+ *
+ * return t_bandlimited_tableset * the set, its status is BANDLIMITED_TABLES_LOADED
+ *				if the cache file had any waveform, BANDLIMITED_TABLES_BUILT if
+ *				they'll be built for it and BANDLIMITED_TABLES_LAZY without one,
+ *				BANDLIMITED_TABLES_NOMEMORY if there's nowhere to build them.
+ *				NULL if there's no memory for the set
+ */
+static t_bandlimited_tableset *bandlimited_dcreate(unsigned int band, int tabbits) {
+	t_bandlimited_tableset *set = (t_bandlimited_tableset *)calloc(1, sizeof(t_bandlimited_tableset));
+	double start = bandlimited_clock();
+
+	if(!set)
+		return 0;
+	set->band = band;
+	set->tabbits = tabbits;
+	set->read4 = bandlimited_read4_sized(tabbits);
+	bandlimited_dlayout(set);
+	bandlimited_cachefile(set);
+	if(bandlimited_dallocalltables(set)) {
+		bandlimited_dfreealltables(set);
+		return 0;
+	}
+	if(bandlimited_dloadalltables(set) == 0)
+		set->status = BANDLIMITED_TABLES_LOADED;
+	else if(!set->arena.data)
+		set->status = BANDLIMITED_TABLES_NOMEMORY;
+	else if(!set->cachefile[0])
+		set->status = BANDLIMITED_TABLES_LAZY;
+	else
+		set->status = BANDLIMITED_TABLES_BUILT;
+	set->time = bandlimited_clock() - start;
+	return set;
+}
+
+/*
+ * This function sets up what every table set shares, see
+ * bandlimited_tables_new. It's called with the lock held.
+ *
+ */
+static void bandlimited_dinit(void) {
+	const char *env;
+	char *end;
+
+	bandlimited_read4_init();
+	bandlimited_dmaketable();
+	if(!bandlimited_budgetset && (env = getenv("BANDLIMITED_BUDGET")) && *env) {
+		bandlimited_budget = strtoul(env, &end, 10);
+		if(*end == 'k' || *end == 'K')
+			bandlimited_budget *= 1024;
+		else if(*end == 'm' || *end == 'M')
+			bandlimited_budget *= 1024 * 1024;
+	}
+	if(!bandlimited_hugepagesset && (env = getenv("BANDLIMITED_HUGEPAGES")) && *env)
+		bandlimited_hugepages = atoi(env);
+	bandlimited_lazyns = 0;
+	bandlimited_lazytables = 0;
+}
+
+/*
+ * This function takes a reference on the wavetables. The table sets
+ * themselves are created as oscillators get a sample rate, see
+ * bandlimited_osc_setsr, and stay until the last reference is dropped.
+ * It can be called from any thread: while the tables exist a reference is
+ * just an atomic increment, setting them up is done once, under a lock,
+ * and every other caller waits for it.
+ *
+ * return int 1 on the first call, 0 if the tables already existed
+ */
+int bandlimited_tables_new(void) {
+	long count = __atomic_load_n(&bandlimited_count, __ATOMIC_RELAXED);
+	int first = 0;
+
+	// unless the last reference is on its way out
+	while(count > 0)
+		if(__atomic_compare_exchange_n(&bandlimited_count, &count, count + 1, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			return 0;
+	bandlimited_lock();
+	if(__atomic_load_n(&bandlimited_count, __ATOMIC_RELAXED) == 0l) {
+		bandlimited_dinit();
+		first = 1;
+	}
+	__atomic_add_fetch(&bandlimited_count, 1, __ATOMIC_RELEASE);
+	bandlimited_unlock();
+	return first;
+}
+
+/*
+ * This function tells how much memory the wavetables of every table set
+ * take, the sin table included. Lazy tables only count once they're built.
+ *
+ * param unsigned int * where the number of wavetables is stored. May be NULL
+ *
+ * return size_t bytes, 0 if there are no tables
+ */
+size_t bandlimited_tables_bytes(unsigned int *tables) {
+	t_bandlimited_tableset *set;
+	size_t bytes = 0;
+	unsigned int b, i, w, n = 0, s;
+
+	for(s = 0; s < BANDLIMITED_TABSIZES; s++)
+		for(b = 0; b < BANDLIMITED_MAXBANDS; b++)
+			if((set = __atomic_load_n(&bandlimited_sets[s][b], __ATOMIC_ACQUIRE)))
+				for(w = 0; w < BANDLIMITED_CACHE_WAVES; w++)
+					for(i = 0; i < set->nlevels; i++)
+						if(bandlimited_slot(&set->tables[w][i])) {
+							bytes += BANDLIMITED_TABSTRIDE(set->tabbits, bandlimited_folds[w]);
+							n++;
+						}
+	if(bandlimited_sin_made)
+		bytes += (BANDLIMITED_TABSIZE+3) * sizeof(float);
+	if(tables)
+		*tables = n;
+	return bytes;
+}
+
+/*
+ * This function tells how long building lazy wavetables has taken so far,
+ * see bandlimited_dmissing. It's spread over the blocks that needed them.
+ *
+ * param unsigned int * where the number of lazily built tables is stored. May be NULL
+ *
+ * return double seconds
+ */
+double bandlimited_tables_lazytime(unsigned int *tables) {
+	if(tables)
+		*tables = __atomic_load_n(&bandlimited_lazytables, __ATOMIC_RELAXED);
+	return __atomic_load_n(&bandlimited_lazyns, __ATOMIC_RELAXED) * 1e-9;
+}
+
+/*
+ * This function drops a reference on the wavetables. The last
+ * reference frees every table set.
+ *
+ * return int 1 if the tables were freed, 0 otherwise
+ */
+int bandlimited_tables_free(void) {
+	long count = __atomic_load_n(&bandlimited_count, __ATOMIC_RELAXED);
+	unsigned int b, s;
+	int freed = 0;
+
+	while(count > 1)
+		if(__atomic_compare_exchange_n(&bandlimited_count, &count, count - 1, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+			return 0;
+	// the last reference, unless another one is taken meanwhile
+	bandlimited_lock();
+	if(__atomic_sub_fetch(&bandlimited_count, 1, __ATOMIC_ACQ_REL) == 0l) {
+		for(s = 0; s < BANDLIMITED_TABSIZES; s++)
+			for(b = 0; b < BANDLIMITED_MAXBANDS; b++)
+				if(bandlimited_sets[s][b]) {
+					bandlimited_dfreealltables(bandlimited_sets[s][b]);
+					bandlimited_sets[s][b] = 0;
+				}
+		bandlimited_sin_made = 0;
+		freed = 1;
+	}
+	bandlimited_unlock();
+	return freed;
+}
+
+/*
+ * This function maps a waveform name onto its type.
+ *
+ * param const char * name of the waveform: square, triangle, saw, rsaw, sawtriangle, pulse
+ * param t_bandlimited_wave * where the type is stored
+ *
+ * return int 0 on sucess, 1 on failure (invalid name)
+ */
+int bandlimited_wave_parse(const char *name, t_bandlimited_wave *wave) {
+	if(strcmp(name, "saw") == 0) {
+		*wave = BANDLIMITED_SAW;
+	} else if(strcmp(name, "rsaw") == 0) {
+		*wave = BANDLIMITED_RSAW;
+	} else if(strcmp(name, "square") == 0) {
+		*wave = BANDLIMITED_SQUARE;
+	} else if(strcmp(name, "triangle") == 0) {
+		*wave = BANDLIMITED_TRIANGLE;
+	} else if(strcmp(name, "sawtriangle") == 0) {
+		*wave = BANDLIMITED_SAWTRIANGLE;
+	} else if(strcmp(name, "pulse") == 0) {
+		*wave = BANDLIMITED_PULSE;
+	} else {
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ * This function sets the waveform type. In a table set for a band wider
+ * than the audible one the exact and crossfaded modes both read the level
+ * below, which already reaches BANDLIMITED_AUDIBLE, and only correct the
+ * harmonics that are heard: the ones up to a maximum held below the cutoff,
+ * or the ones above it below the first level. A crossfade would only blend
+ * harmonics above the audible band. The first oscillator to
+ * pick a waveform builds its first level, and starts building the rest on
+ * a worker thread if they're cached and aren't in the cache file yet, see
+ * bandlimited_dcachelater.
+ *
+ * param t_bandlimited_osc* pointer to the oscillator
+ * param t_bandlimited_wave waveform type
+ *
+ * return int 1 if the waveform is being built for the set's cache file
+ */
+static int bandlimited_osc_pickwave(t_bandlimited_osc *x, t_bandlimited_wave wave) {
+	int table = BANDLIMITED_SAWTABLE;
+
+	x->wave = wave;
+	x->kernelmode = x->mode;
+	if(x->set && x->set->band && x->mode != BANDLIMITED_APPROXIMATE) {
+		x->kernelmode = BANDLIMITED_EXACT;
+		x->kernel = bandlimited_wide_kernels[wave];
+		x->unison_kernel = bandlimited_wide_unison_kernels[wave];
+	} else {
+		x->kernel = bandlimited_kernels[wave][x->kernelmode];
+		x->unison_kernel = bandlimited_unison_kernels[wave][x->kernelmode];
+	}
+	switch(wave) {
+		case BANDLIMITED_SAW:
+		case BANDLIMITED_RSAW:
+		case BANDLIMITED_PULSE:
+			table = BANDLIMITED_SAWTABLE;
+			break;
+		case BANDLIMITED_SQUARE:
+			table = BANDLIMITED_SQUARETABLE;
+			break;
+		case BANDLIMITED_TRIANGLE:
+			table = BANDLIMITED_TRIANGLETABLE;
+			break;
+		case BANDLIMITED_SAWTRIANGLE:
+			table = BANDLIMITED_SAWTRIANGLETABLE;
+			break;
+	}
+	if(!x->set)
+		return 0;
+	// there's a first level to fall back on unless another thread is still
+	// building it, until then it's silent, see bandlimited_dmissing
+	if(!bandlimited_slot(&x->set->tables[table][0]))
+		bandlimited_dlazypair(x->set, table, 0, 0);
+	return x->set->cachefile[0] ? bandlimited_dcachelater(x->set, table) : 0;
+}
+
+/*
+ * This function sets the waveform type, see bandlimited_osc_pickwave.
+ *
+ * param t_bandlimited_osc* pointer to the oscillator
+ * param t_bandlimited_wave waveform type
+ */
+void bandlimited_osc_settype(t_bandlimited_osc *x, t_bandlimited_wave wave) {
+	bandlimited_osc_pickwave(x, wave);
+}
+
+/*
+ * This function switches between the exact, approximate and crossfaded generators.
+ *
+ * param t_bandlimited_osc* pointer to the oscillator
+ * param t_bandlimited_mode generator mode
+ */
+void bandlimited_osc_setmode(t_bandlimited_osc *x, t_bandlimited_mode mode) {
+	x->mode = mode;
+	bandlimited_osc_settype(x, x->wave);
+}
+
+/*
+ * This function points the oscillator at the table set for its sample
+ * rate, cutoff and table size, creating the set if no oscillator has used
+ * it yet. Sets are shared by every oscillator of the same band (see
+ * bandlimited_band) and table size. If there's no memory for a new set the
+ * oscillator keeps the one it had, a first one renders silence.
+ *
+ * param t_bandlimited_osc* pointer to the oscillator
+ *
+ * return int BANDLIMITED_TABLES_LOADED or BANDLIMITED_TABLES_LAZY if the set
+ *				was created, BANDLIMITED_TABLES_BUILT if the oscillator's
+ *				waveform is being built for its cache file,
+ *				BANDLIMITED_TABLES_NOMEMORY if the set couldn't be made or
+ *				has nowhere to build its tables, 0 otherwise
+ */
+static int bandlimited_osc_setset(t_bandlimited_osc *x) {
+	unsigned int band = bandlimited_band(x->sr, x->cutoff);
+	t_bandlimited_tableset **slot = &bandlimited_sets[x->tabbits - BANDLIMITED_MINTABBITS][band];
+	t_bandlimited_tableset *set = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+	int status = 0;
+
+	if(!set) {
+		bandlimited_lock();
+		if(!(set = *slot) && (set = bandlimited_dcreate(band, x->tabbits))) {
+			status = set->status;
+			__atomic_store_n(slot, set, __ATOMIC_RELEASE);
+		}
+		bandlimited_unlock();
+		if(!set)
+			return BANDLIMITED_TABLES_NOMEMORY;
+	}
+	if(set != x->set) {
+		// the levels read were the old set's
+		memset(x->stats.levels, 0, sizeof(x->stats.levels));
+		x->set = set;
+		if(bandlimited_osc_pickwave(x, x->wave))
+			status = BANDLIMITED_TABLES_BUILT;
+	}
+	return status;
+}
+
+/*
+ * This function sets the sample rate the oscillator renders at, and with
+ * it the table set it reads, see bandlimited_osc_setset. The wavetables
+ * must have been referenced with bandlimited_tables_new.
+ *
+ * param t_bandlimited_osc* pointer to the oscillator
+ * param float sample rate in hz
+ *
+ * return int BANDLIMITED_TABLES_BUILT, BANDLIMITED_TABLES_LOADED or
+ *				BANDLIMITED_TABLES_LAZY if a table set was created,
+ *				BANDLIMITED_TABLES_NOMEMORY if it couldn't be, 0 otherwise
+ */
+int bandlimited_osc_setsr(t_bandlimited_osc *x, float sr) {
+	x->sr = sr;
+	x->conv = 1.0f/sr;
+	x->s_nq = sr / 2.0f - 1;
+	return bandlimited_osc_setset(x);
+}
+
+/*
+ * This function sets the cutoff frequency, which can move the oscillator
+ * onto another table set once it has a sample rate.
+ *
+ * param t_bandlimited_osc* pointer to the oscillator
+ * param float cutoff frequency, 0 for the nyquist limit
+ *
+ * return int see bandlimited_osc_setsr
+ */
+int bandlimited_osc_setcutoff(t_bandlimited_osc *x, float cutoff) {
+	x->cutoff = cutoff;
+	return x->sr > 0 ? bandlimited_osc_setset(x) : 0;
+}
+
+/*
+ * This function sets the size of the wavetables the oscillator reads, which
+ * moves it onto another table set once it has a sample rate. Smaller
+ * tables keep more voices in the CPU caches but interpolate less cleanly
+ * and stop at fewer harmonics, see bandlimited_dlayout. Every size has
+ * its own block readers.
+ *
+ * param t_bandlimited_osc* pointer to the oscillator
+ * param int points, rounded to a power of 2 from 512 to 4096, 0 for BANDLIMITED_TABSIZE
+ *
+ * return int see bandlimited_osc_setsr
+ */
+int bandlimited_osc_settabsize(t_bandlimited_osc *x, int size) {
+	int bits = BANDLIMITED_MINTABBITS;
+
+	if(size <= 0)
+		bits = BANDLIMITED_TABBITS;
+	while(size > 0 && bits < BANDLIMITED_MAXTABBITS && (1 << bits) + (1 << (bits - 1)) <= size)
+		bits++;
+	x->tabbits = bits;
+	return x->sr > 0 ? bandlimited_osc_setset(x) : 0;
+}
+
+/*
+ * return int the number of points of the oscillator's wavetables
+ */
+int bandlimited_osc_tabsize(const t_bandlimited_osc *x) {
+	return 1 << x->tabbits;
+}
+
+/*
+ * This function stacks detuned copies of the waveform: voices spread
+ * evenly over detune cents, summed and scaled by 1 / sqrt(voices) so the
+ * stack is about as loud as a single voice. The phases aren't touched,
+ * voices start spread of a period apart when the oscillator restarts
+ * after silence or its phase is set.
+ *
+ * param t_bandlimited_osc* pointer to the oscillator
+ * param int number of voices, 1 to BANDLIMITED_MAXUNISON, 1 is no unison
+ * param float cents between the lowest and the highest voice
+ * param float 0 to 1, how much of a period the voices' phases spread over
+ */
+void bandlimited_osc_setunison(t_bandlimited_osc *x, int voices, float detune, float spread) {
+	int v;
+
+	if(voices < 1)
+		voices = 1;
+	else if(voices > BANDLIMITED_MAXUNISON)
+		voices = BANDLIMITED_MAXUNISON;
+	// the last voice is the highest, the stack's tables are picked for it
+	detune = fabsf(detune);
+	x->unison = voices;
+	x->unison_gain = 1.0f / sqrtf(voices);
+	for(v = 0; v < voices; v++) {
+		x->unison_ratio[v] = voices > 1 ? powf(2.0f, detune * ((float)v / (voices - 1) - 0.5f) / 1200.0f) : 1.0f;
+		x->unison_offset[v] = bandlimited_fixphase(spread * v / voices);
+	}
+}
+
+/*
+ * This function sets the phase of the oscillator, unison voices get theirs
+ * spread from it.
+ *
+ * param t_bandlimited_osc* pointer to the oscillator
+ * param double phase
+ */
+void bandlimited_osc_setphase(t_bandlimited_osc *x, double phase) {
+	int v;
+
+	for(v = 0; v < x->unison; v++)
+		x->phase[v] = bandlimited_fixphase(phase) + x->unison_offset[v];
+}
+
+/*
+ * This function initializes an oscillator. The sample rate must be set
+ * with bandlimited_osc_setsr before rendering, until then it renders
+ * silence.
+ *
+ * param t_bandlimited_osc* pointer to the oscillator
+ * param t_bandlimited_wave waveform type
+ * param unsigned int max number of generated harmonics
+ * param float cutoff frequency, 0 for the nyquist limit
+ * param t_bandlimited_mode generator mode
+ */
+void bandlimited_osc_init(t_bandlimited_osc *x, t_bandlimited_wave wave, unsigned int max_harmonics, float cutoff, t_bandlimited_mode mode) {
+	bandlimited_osc_setunison(x, 1, 0.0f, 0.0f);
+	bandlimited_osc_setphase(x, 0.0);
+	x->sr = 0;
+	x->conv = 0;
+	x->s_nq = 0;
+	x->cutoff = cutoff;
+	x->max_harmonics = max_harmonics;
+	x->mode = mode;
+	x->tabbits = BANDLIMITED_TABBITS;
+	x->set = 0;
+	bandlimited_osc_settype(x, wave);
+	bandlimited_osc_resetstats(x);
+}
+
+/*
+ * This function zeroes the oscillator's statistics.
+ *
+ * param t_bandlimited_osc* pointer to the oscillator
+ */
+void bandlimited_osc_resetstats(t_bandlimited_osc *x) {
+	memset(&x->stats, 0, sizeof(x->stats));
+}
+
+/*
+ * This function counts the wavetable levels an oscillator has read from
+ * its table set.
+ *
+ * param const t_bandlimited_osc * pointer to the oscillator
+ * param unsigned int * where the harmonics of the lowest level read are stored, may be NULL
+ * param unsigned int * where the harmonics of the highest level read are stored, may be NULL
+ *
+ * return unsigned int number of levels read, 0 if none (low and high are left alone)
+ */
+unsigned int bandlimited_stats_levels(const t_bandlimited_osc *x, unsigned int *low, unsigned int *high) {
+	const t_bandlimited_stats *s = &x->stats;
+	unsigned int i, n = 0;
+
+	for(i = 0; x->set && i < x->set->nlevels; i++) {
+		if(!(s->levels[i >> 5] & 1u << (i & 31)))
+			continue;
+		if(n++ == 0 && low)
+			*low = x->set->levels[i];
+		if(high)
+			*high = x->set->levels[i];
+	}
+	return n;
+}
+
+/*
+ * This function renders a block of samples without resetting the lazy
+ * table budget, see bandlimited_osc_render.
+ */
+static inline void bandlimited_renderblock(t_bandlimited_osc *x, const float *in, const float *dutycycle, float *out, int n) {
+	int i;
+
+	x->stats.samples += n;
+	for(i = 0; i < n && in[i] <= 0.0f; i++)
+		;
+	if(n > 0 && (i == n || !x->set)) {
+		// a silent voice: the phasor restarts, just like the kernel would leave it
+		memset(out, 0, n * sizeof(float));
+		bandlimited_osc_setphase(x, 0.0);
+		return;
+	}
+	if(x->unison == 1)
+		x->kernel(x, in, dutycycle, out, n);
+	else if(x->unison_kernel)
+		x->unison_kernel(x, in, out, n);
+	else
+		bandlimited_unison_voices(x, in, dutycycle, out, n);
+}
+
+/*
+ * This function renders a block of samples.
+ *
+ * param t_bandlimited_osc* pointer to the oscillator
+ * param const float * frequency of each sample in hz, zero or less outputs silence
+ * param const float * duty cycle of each sample (pulse only), 0 for a constant 0.5
+ * param float * output buffer
+ * param int number of samples to render
+ */
+void bandlimited_osc_render(t_bandlimited_osc *x, const float *in, const float *dutycycle, float *out, int n) {
+	bandlimited_lazybudget = BANDLIMITED_LAZYPAIRS;
+	bandlimited_renderblock(x, in, dutycycle, out, n);
+}
+
+/*
+ * This function renders a block of samples for several voices sharing the
+ * oscillator's waveform, mode and wavetables, each with its own phases,
+ * cutoff and maximum (see bandlimited_voices_resize). The voices are
+ * rendered one after another along their samples, so a held note still
+ * gets its wavetables picked once a chunk, and the kernels' loops stay
+ * along the samples they vectorize over. Every buffer holds one block per
+ * voice, back to back.
+ *
+ * param t_bandlimited_osc* pointer to the oscillator, its own phases, cutoff and maximum are not used
+ * param t_bandlimited_voices * state of the voices
+ * param const float * frequency of each sample in hz, zero or less outputs silence
+ * param const float * duty cycle of each sample (pulse only), 0 for a constant 0.5
+ * param int number of duty cycle blocks, they repeat when there are fewer than voices
+ * param float * output buffer
+ * param int number of samples to render per voice
+ */
+void bandlimited_osc_rendervoices(t_bandlimited_osc *x, t_bandlimited_voices *voices, const float *in,
+								  const float *dutycycle, int dcvoices, float *out, int n) {
+	float cutoff = x->cutoff;
+	unsigned int max_harmonics = x->max_harmonics;
+	int u, v;
+
+	bandlimited_lazybudget = BANDLIMITED_LAZYPAIRS;
+	for(v = 0; v < voices->n; v++, in += n, out += n) {
+		for(u = 0; u < x->unison; u++)
+			x->phase[u] = voices->phase[u * voices->n + v];
+		x->cutoff = voices->cutoff[v];
+		x->max_harmonics = voices->max_harmonics[v];
+		bandlimited_renderblock(x, in, dutycycle ? dutycycle + (v % dcvoices) * n : 0, out, n);
+		for(u = 0; u < x->unison; u++)
+			voices->phase[u * voices->n + v] = x->phase[u];
+	}
+	x->cutoff = cutoff;
+	x->max_harmonics = max_harmonics;
+}
+
+/*
+ * This function sets the number of voices. Voices that are kept keep their
+ * phases, cutoff and maximum, new ones start at phase 0 with the
+ * oscillator's cutoff and maximum.
+ *
+ * param t_bandlimited_voices * voices, zeroed the first time
+ * param int number of voices, at least 1
+ * param const t_bandlimited_osc * oscillator the voices are rendered by
+ *
+ * return int 0, or 1 if out of memory (the voices are left as they were)
+ */
+int bandlimited_voices_resize(t_bandlimited_voices *vs, int n, const t_bandlimited_osc *x) {
+	t_bandlimited_phase *phase = (t_bandlimited_phase *)calloc((size_t)n * BANDLIMITED_MAXUNISON, sizeof(t_bandlimited_phase));
+	float *cutoff = (float *)malloc(n * sizeof(float));
+	unsigned int *max_harmonics = (unsigned int *)malloc(n * sizeof(unsigned int));
+	int u, v;
+
+	if(!phase || !cutoff || !max_harmonics) {
+		free(phase);
+		free(cutoff);
+		free(max_harmonics);
+		return 1;
+	}
+	for(v = 0; v < n; v++) {
+		if(v < vs->n) {
+			for(u = 0; u < BANDLIMITED_MAXUNISON; u++)
+				phase[u * n + v] = vs->phase[u * vs->n + v];
+			cutoff[v] = vs->cutoff[v];
+			max_harmonics[v] = vs->max_harmonics[v];
+		} else {
+			cutoff[v] = x->cutoff;
+			max_harmonics[v] = x->max_harmonics;
+		}
+	}
+	bandlimited_voices_free(vs);
+	vs->n = n;
+	vs->phase = phase;
+	vs->cutoff = cutoff;
+	vs->max_harmonics = max_harmonics;
+	return 0;
+}
+
+/*
+ * This function frees the voices' arrays and leaves none.
+ *
+ * param t_bandlimited_voices * voices
+ */
+void bandlimited_voices_free(t_bandlimited_voices *vs) {
+	free(vs->phase);
+	free(vs->cutoff);
+	free(vs->max_harmonics);
+	vs->n = 0;
+	vs->phase = 0;
+	vs->cutoff = 0;
+	vs->max_harmonics = 0;
+}
+
+/*
+ * This function sets the phase of every voice, unison voices get theirs
+ * spread from it as bandlimited_osc_setphase does.
+ *
+ * param t_bandlimited_voices * voices
+ * param const t_bandlimited_osc * oscillator the voices are rendered by
+ * param double phase
+ */
+void bandlimited_voices_setphase(t_bandlimited_voices *vs, const t_bandlimited_osc *x, double phase) {
+	int u, v;
+
+	for(u = 0; u < x->unison; u++)
+		for(v = 0; v < vs->n; v++)
+			vs->phase[u * vs->n + v] = bandlimited_fixphase(phase) + x->unison_offset[u];
+}
+
+#ifdef DEBUG
+double bandlimited_testsin(float p) {
+	return bandlimited_sin(bandlimited_fixphase(p), 0);
+}
+
+double bandlimited_testsin_lin(float p) {
+	return bandlimited_sin_lin(bandlimited_sin_table, p);
+}
+
+unsigned int bandlimited_nearest(const t_bandlimited_osc *x, unsigned int max_harmonics) {
+	return x->set->levels[bandlimited_harmpos(x->set, max_harmonics) - 1];
+}
+
+/*
+ * This function evaluates a single harmonic of the oscillator's exact waveform.
+ *
+ * return int 0 on sucess, 1 if the waveform has no harmonic function
+ */
+int bandlimited_harmonic(t_bandlimited_osc *x, unsigned int i, float p, float *out) {
+	float (*generator)(unsigned int, unsigned int, t_bandlimited_phase, int)=0;
+	
+	if(x->mode != BANDLIMITED_EXACT)
+		return 1;
+	switch(x->wave) {
+		case BANDLIMITED_SAW:
+		case BANDLIMITED_RSAW:
+		case BANDLIMITED_PULSE:
+			generator = &bandlimited_sawwavepart;
+			break;
+		case BANDLIMITED_SQUARE:
+			generator = &bandlimited_squarepart;
+			break;
+		case BANDLIMITED_TRIANGLE:
+			generator = &bandlimited_trianglepart;
+			break;
+		case BANDLIMITED_SAWTRIANGLE:
+			generator = &bandlimited_sawtrianglepart;
+			break;
+	}
+	*out = generator(i, i, bandlimited_fixphase(p), 0);
+	return 0;
+}
+#endif
@@ -0,0 +1,204 @@
+/**
+
+
+Apache License 2.0
+
+bandlimited~
+    Copyright [2010] Paulo Casaes
+
+      This product includes software developed at
+      Github (https://github.com/pcasaes/bandlimited).
+
+ --
+ https://github.com/pcasaes/bandlimited
+ mailto:pcasaes@gmail.com
+
+ v 0.93
+ */
+
+/*
+ * Pd independent oscillator core. Holds the shared wavetables, the
+ * waveform generators and a block render entry point. Nothing in here
+ * includes m_pd.h, so it can be linked into any host that can hand it
+ * a frequency buffer and an output buffer.
+ */
+
+#ifndef BANDLIMITED_CORE_H_
+#define BANDLIMITED_CORE_H_
+
+#include <stddef.h>
+#include "bandlimited_defs.h"
+
+
+typedef enum _bandlimited_wave
+	{
+		BANDLIMITED_SAW = 0,
+		BANDLIMITED_RSAW,
+		BANDLIMITED_SQUARE,
+		BANDLIMITED_TRIANGLE,
+		BANDLIMITED_SAWTRIANGLE,
+		BANDLIMITED_PULSE
+	} t_bandlimited_wave;
+
+/*
+ * Exact renders the precise number of harmonics, approximate uses the
+ * wavetable below it and crossfade blends the wavetables around it.
+ */
+typedef enum _bandlimited_mode
+	{
+		BANDLIMITED_EXACT = 0,
+		BANDLIMITED_APPROXIMATE,
+		BANDLIMITED_CROSSFADE
+	} t_bandlimited_mode;
+
+/*
+ * Unison stacks up to BANDLIMITED_MAXUNISON detuned copies of the waveform
+ * in one oscillator, see bandlimited_osc_setunison.
+ */
+#define BANDLIMITED_MAXUNISON 16
+
+/*
+ * What an oscillator has been doing, cheap enough to always count. Every
+ * sample a block kernel picks its wavetables for counts once in picks. A
+ * held frequency counts a whole chunk at once, a changing one is sampled
+ * every BANDLIMITED_STATSSTRIDE samples. In exact mode residual is a
+ * histogram of how many harmonics the correction spans: 0, 1, 2-3, 4-7
+ * and so on, the last bucket holds everything above. See
+ * bandlimited_osc_resetstats and bandlimited_stats_levels.
+ */
+#define BANDLIMITED_STATSBUCKETS 8
+#define BANDLIMITED_STATSSTRIDE 8
+
+typedef struct _bandlimited_stats
+	{
+		uint64_t samples;			// rendered, silence included
+		uint64_t picks;				// wavetable picks
+		uint64_t above;				// picks past the wavetables, rendered with polyBLEPs
+		uint64_t residual[BANDLIMITED_STATSBUCKETS];
+		uint32_t levels[(BANDLIMITED_HAMSIZE + 31) / 32];	// bit per level read
+	} t_bandlimited_stats;
+
+/*
+ * Wavetables of every waveform laid out for one band, see
+ * bandlimited_osc_setsr.
+ */
+typedef struct _bandlimited_tableset t_bandlimited_tableset;
+
+/*
+ * The voices an oscillator renders in one call, see
+ * bandlimited_osc_rendervoices. Their state is kept structure of arrays:
+ * a voice is its index in every array, and only the unison phases in use
+ * are touched. See bandlimited_voices_resize.
+ */
+typedef struct _bandlimited_voices
+	{
+		int n;
+		//phase of every unison voice of every voice, unison voice u of voice v at u * n + v
+		t_bandlimited_phase *phase;
+		//cutoff (0 for the nyquist limit) and max number of harmonics of every voice
+		float *cutoff;
+		unsigned int *max_harmonics;
+	} t_bandlimited_voices;
+
+typedef struct _bandlimited_osc
+	{
+		//phasor, one phase per unison voice
+		t_bandlimited_phase phase[BANDLIMITED_MAXUNISON];
+		float sr;
+		float conv;
+
+		//bandlimited
+		float s_nq;
+		float cutoff;
+		unsigned int max_harmonics;
+		t_bandlimited_mode mode;
+		t_bandlimited_wave wave;
+		//wavetables for the band and size, and the mode they're read in
+		int tabbits;
+		t_bandlimited_tableset *set;
+		t_bandlimited_mode kernelmode;
+
+		//unison
+		int unison;
+		float unison_gain;
+		float unison_ratio[BANDLIMITED_MAXUNISON];
+		t_bandlimited_phase unison_offset[BANDLIMITED_MAXUNISON];
+
+		//type, the block kernel of the waveform
+		void (*kernel)(struct _bandlimited_osc *, const float *, const float *, float *, int);
+		//the unison kernel, 0 if the waveform and mode have none
+		void (*unison_kernel)(struct _bandlimited_osc *, const float *, float *, int);
+
+		t_bandlimited_stats stats;
+
+	} t_bandlimited_osc;
+
+
+/*
+ * Wavetables are shared by every oscillator. bandlimited_tables_new must be
+ * called before the first oscillator gets a sample rate and
+ * bandlimited_tables_free once for every call to bandlimited_tables_new.
+ * The tables come in sets, one per band and table size: oscillators whose
+ * sample rate (or cutoff) reach the same half octave above
+ * BANDLIMITED_AUDIBLE share a set, laid out so its levels cover the
+ * audible band at that rate, if they read the same size of wavetables. The
+ * first oscillator of a band loads the waveforms its cache file has (see
+ * bandlimited_cache.h). The others are only built once an oscillator picks
+ * them, on a worker thread and lazily until it's done, and then written to
+ * the cache file, see bandlimited_tables_wait. Without a cache file only the
+ * tables the oscillators actually read are built, as they're first needed.
+ * bandlimited_tables_setbudget trades the number of tables for memory.
+ * Each set is one aligned arena, optionally on huge pages, see
+ * bandlimited_tables_sethugepages.
+ * Any thread may take and drop references and oscillators on different
+ * threads may render at the same time, see bandlimited_tables_new.
+ * Rendering never waits for another thread: a level someone else is still
+ * building is read from the level below until it's there.
+ */
+#define BANDLIMITED_TABLES_BUILT 1
+#define BANDLIMITED_TABLES_LOADED 2
+#define BANDLIMITED_TABLES_LAZY 3
+#define BANDLIMITED_TABLES_NOMEMORY 4
+
+int bandlimited_tables_new(void);
+int bandlimited_tables_free(void);
+void bandlimited_tables_wait(void);
+void bandlimited_tables_setcache(const char *path);
+void bandlimited_tables_setbudget(size_t bytes);
+void bandlimited_tables_sethugepages(int huge);
+size_t bandlimited_tables_bytes(unsigned int *tables);
+double bandlimited_tables_lazytime(unsigned int *tables);
+unsigned int bandlimited_tableset_levels(const t_bandlimited_tableset *set);
+const char *bandlimited_tableset_cachefile(const t_bandlimited_tableset *set);
+double bandlimited_tableset_time(const t_bandlimited_tableset *set, int *threads);
+int bandlimited_tableset_hugepages(const t_bandlimited_tableset *set);
+
+int bandlimited_wave_parse(const char *name, t_bandlimited_wave *wave);
+
+void bandlimited_osc_init(t_bandlimited_osc *x, t_bandlimited_wave wave, unsigned int max_harmonics, float cutoff, t_bandlimited_mode mode);
+void bandlimited_osc_settype(t_bandlimited_osc *x, t_bandlimited_wave wave);
+void bandlimited_osc_setmode(t_bandlimited_osc *x, t_bandlimited_mode mode);
+int bandlimited_osc_setsr(t_bandlimited_osc *x, float sr);
+int bandlimited_osc_setcutoff(t_bandlimited_osc *x, float cutoff);
+int bandlimited_osc_settabsize(t_bandlimited_osc *x, int size);
+int bandlimited_osc_tabsize(const t_bandlimited_osc *x);
+void bandlimited_osc_setunison(t_bandlimited_osc *x, int voices, float detune, float spread);
+void bandlimited_osc_setphase(t_bandlimited_osc *x, double phase);
+void bandlimited_osc_render(t_bandlimited_osc *x, const float *in, const float *dutycycle, float *out, int n);
+void bandlimited_osc_rendervoices(t_bandlimited_osc *x, t_bandlimited_voices *voices, const float *in,
+								  const float *dutycycle, int dcvoices, float *out, int n);
+void bandlimited_osc_resetstats(t_bandlimited_osc *x);
+unsigned int bandlimited_stats_levels(const t_bandlimited_osc *x, unsigned int *low, unsigned int *high);
+
+int bandlimited_voices_resize(t_bandlimited_voices *v, int n, const t_bandlimited_osc *x);
+void bandlimited_voices_free(t_bandlimited_voices *v);
+void bandlimited_voices_setphase(t_bandlimited_voices *v, const t_bandlimited_osc *x, double phase);
+
+#ifdef DEBUG
+double bandlimited_testsin(float p);
+double bandlimited_testsin_lin(float p);
+unsigned int bandlimited_nearest(const t_bandlimited_osc *x, unsigned int max_harmonics);
+int bandlimited_harmonic(t_bandlimited_osc *x, unsigned int i, float p, float *out);
+#endif
+
+#endif /*BANDLIMITED_CORE_H_*/
@@ -1,10 +1,129 @@
 #ifndef BANDLIMITED_UTIL_H_
 #define BANDLIMITED_UTIL_H_
 
+#include "bandlimited_defs.h"
 
-t_float bandlimited_read4(float *table, t_float p) ;
+#ifdef BANDLIMITED_HALF
+/*
+ * These functions convert between floats and IEEE half floats, rounding to
+ * nearest even. Infinities and NaNs aren't handled, tables don't have them.
+ */
+static inline float bandlimited_half2float(uint16_t h) {
+	union { uint32_t u; float f; } v;
+
+	v.u = (uint32_t)(h & 0x7fff) << 13;
+	if(v.u < 1u << 23) {
+		/* denormal, built as 2^-14 + x and taken back so it works with denormals off */
+		v.u += 113u << 23;
+		v.f -= 6.103515625e-05f;
+	} else
+		v.u += 112u << 23;
+	v.u |= (uint32_t)(h & 0x8000) << 16;
+	return v.f;
+}
+
+static inline uint16_t bandlimited_float2half(float x) {
+	union { uint32_t u; float f; } v, denormal;
+	uint32_t sign;
+
+	v.f = x;
+	sign = v.u & 0x80000000u;
+	v.u ^= sign;
+	denormal.u = ((127 - 15) + (23 - 10) + 1) << 23;	/* 0.5, lines denormals up with the mantissa */
+	if(v.u >= (127 + 16) << 23) {
+		v.u = 0x7c00;
+	} else if(v.u < (127 - 14) << 23) {
+		v.f += denormal.f;
+		v.u -= denormal.u;
+	} else {
+		v.u += ((uint32_t)(15 - 127) << 23) + 0xfff + ((v.u >> 13) & 1);
+		v.u >>= 13;
+	}
+	return (uint16_t)(v.u | (sign >> 16));
+}
+#endif
+
+/*
+ * These functions convert a wavetable sample from and to its storage
+ * format, see t_bandlimited_sample.
+ */
+static inline float bandlimited_widen(t_bandlimited_sample s) {
+#if defined(BANDLIMITED_INT16)
+	return s * (BANDLIMITED_INT16_RANGE / 32767.0f);
+#elif defined(BANDLIMITED_HALF)
+	return bandlimited_half2float(s);
+#else
+	return s;
+#endif
+}
+
+static inline t_bandlimited_sample bandlimited_narrow(float x) {
+#if defined(BANDLIMITED_INT16)
+	x *= 32767.0f / BANDLIMITED_INT16_RANGE;
+	return (t_bandlimited_sample)(x >= 32767.0f ? 32767 : x <= -32767.0f ? -32767 : x < 0 ? x - 0.5f : x + 0.5f);
+#elif defined(BANDLIMITED_HALF)
+	return bandlimited_float2half(x);
+#else
+	return x;
+#endif
+}
+
+/*
+ * These functions convert phases between periods and fixed point, see
+ * t_bandlimited_phase. Periods wrap. The float keeps 31 bits so phases
+ * just past a wrap, where the polyBLEPs are steepest, stay precise.
+ */
+static inline t_bandlimited_phase bandlimited_fixphase(double p) {
+	p *= BANDLIMITED_PHASEONE;
+	// rounded, a truncated increment would make every phasor run flat
+	return (t_bandlimited_phase)(int64_t)(p < 0.0 ? p - 0.5 : p + 0.5);
+}
+
+static inline float bandlimited_floatphase(t_bandlimited_phase p) {
+	return (int32_t)(p >> 1) * (1.0f / 2147483648.0f);
+}
+
+/*
+ * return float the fraction of a fixed point phase between two table points
+ */
+static inline float bandlimited_phasefrac(t_bandlimited_phase p) {
+	return (int32_t)(p & ((1u << BANDLIMITED_FRACBITS) - 1)) * (1.0f / (1 << BANDLIMITED_FRACBITS));
+}
+
+
+/*
+ * A block reader, see bandlimited_read4_sized.
+ */
+typedef void (*t_bandlimited_read4)(t_bandlimited_sample *const *tables, const t_bandlimited_phase *phase, float *out, int n);
+
+/*
+ * One zeroed block of memory aligned to BANDLIMITED_TABLEALIGN, see
+ * bandlimited_arena_alloc.
+ */
+typedef struct _bandlimited_arena
+	{
+		void *data;
+		size_t size;
+		void *block;	// what was allocated where it isn't mapped
+		int huge;		// the huge pages it got, see BANDLIMITED_HUGEPAGES
+	} t_bandlimited_arena;
+
+float bandlimited_read4(float *table, t_bandlimited_phase p) ;
+t_bandlimited_read4 bandlimited_read4_sized(int tabbits) ;
+void bandlimited_read4_init(void) ;
+void bandlimited_ifft(double *re, double *im, double *twiddles, int n) ;
+double bandlimited_clock(void) ;
+int bandlimited_ncpus(void) ;
+int bandlimited_parallel(int njobs, void (*job)(void *, int), void *arg) ;
+int bandlimited_detach(void (*job)(void *), void *arg) ;
+void bandlimited_lock(void) ;
+void bandlimited_unlock(void) ;
+void bandlimited_yield(void) ;
+int bandlimited_arena_alloc(t_bandlimited_arena *a, size_t size, int huge) ;
+void bandlimited_arena_free(t_bandlimited_arena *a) ;
+int bandlimited_checkalignment(void) ;
 #ifdef DEBUG
-double bandlimited_sin_lin(t_float p) ;
+double bandlimited_sin_lin(float *table, float p) ;
 #endif
 
 #endif /*BANDLIMITED_UTIL_H_*/
@@ -18,8 +18,9 @@ bandlimited~
 
 #include "m_pd.h"
 #include <math.h>
+#include <stdio.h>
 #include <string.h>
-#include "bandlimited_defs.h"
+#include "bandlimited_core.h"
 #include "bandlimited_util.h"
 
 
@@ -33,617 +34,42 @@ typedef struct _bandlimited
 	{
 		t_object x_obj;
 		
-		//phasor
-		double x_phase;
 		float x_f;      /* scalar frequency */
-		
-
-		
-		
-		
-		//bandlimited
-		float s_nq;
-		float cutoff;
-		unsigned int max_harmonics;
-		int approximate;
 		t_symbol *type;
 		
+		t_bandlimited_osc x_osc;
 		
+		//voices, one per channel of a multichannel input
+		t_bandlimited_voices x_voices;
 		
-		//type
-		t_float (*generator)(unsigned int, t_float, t_float);
-		
-		
-		
+		//stats, time spent in the perform routine
+		double x_time;
+		uint64_t x_performed;	/* samples per voice */
 		
 	} t_bandlimited;
 
-#define bandlimited_read(q,w) bandlimited_read4((q),(w))
-
-
-
-
-/*
- * This variables sets the sin function being used. When building 
- * the wave tables the real sin function should be used. When generating
- * a signal the 4point interpolation sin wavetable function should be used.
- *
- * param t_float phase
- *
- * return double evaluation of sin function
- */
-static double (*bandlimited_sin)(t_float);
-
-/*
- * This function performs sin(2pi *x) using the real sin function.
- *
- * param t_float phase
- *
- * return double evaluation of sin function
- */
-static double bandlimited_sin_real(t_float p) {
-	return sin((2.0 * BANDLIMITED_PI)*p);
-}
-
-
-/*
- * This function performs sin(2pi * x) using 4-point interpolation on top of a wavetable.
- *
- * param t_float phase
- *
- * return double evaluation of sin function
- */
-static double bandlimited_sin_4point(t_float p) {
-	return bandlimited_read(bandlimited_sin_table, p);
-}
-
-
-/*
- * calculates the wavetable position that is nearest to the number of 
- * harmonics specified
- *
- * param unsigned int max harmonics to lookup
- *
- * return unsigned int wavetable position + 1
- */
-static inline unsigned int bandlimited_harmpos(unsigned int max_harmonics) {
-	
-	unsigned int pos =  rint((1.0f*max_harmonics)/BANDLIMITED_INCREMENT);
-	if(pos > BANDLIMITED_HAMSIZE)
-		pos = BANDLIMITED_HAMSIZE;
-	else if(pos == 0)
-		pos=1;
-	
-	return pos;
-	
-}
-
-/*
- * calculates the wavetable position that is nearest to and below the number of 
- * harmonics specified
- *
- * param unsigned int max harmonics to lookup
- *
- * return unsigned int wavetable position + 1
- */
-static inline unsigned int bandlimited_harmposfloor(unsigned int max_harmonics) {
-	
-	unsigned int pos =  (unsigned int)fmin(floor((1.0f*max_harmonics)/BANDLIMITED_INCREMENT),BANDLIMITED_HAMSIZE);
-	if(pos > BANDLIMITED_HAMSIZE)
-		pos = BANDLIMITED_HAMSIZE;
-	else if(pos ==0 )
-		pos=1;
-	
-	return pos;
-	
-}
-
-
-
-/*
- * This function calculates the harmonic components for a square wave on
- * phase p from start to max_harmonics
- *
- * param unsigned int starting harmonic
- * param unsigned int stopping harmonic
- * param t_float phase
- *
- * return t_float the calculated wave component
- */
-static t_float bandlimited_squarepart(unsigned int start, unsigned int max_harmonics, t_float p) {
-	unsigned  int i;
-	double sum=0.0f;
-	
-	
-	for(i = start; i <= max_harmonics; i += 2) {
-		
-		sum += bandlimited_sin(p * i )/i;
-	}
-	
-	return  4.0f *sum / BANDLIMITED_PI;
-}
-							   
-
-/*
- * This function generates a normalized square wave with a maximum number
- * of harmonics at a certain phase.
- *
- * param unsigned int maxium number of generated harmonics
- * param t_float phase
- *
- * return t_float the calculated wave
- */
-static t_float bandlimited_square(unsigned int max_harmonics, t_float p, t_float dutycycle) {
-
-	unsigned int pos = bandlimited_harmpos(max_harmonics);
-	
-	unsigned int nearest = (pos) * BANDLIMITED_INCREMENT;
-	
-	double sum;
-	sum = bandlimited_read(bandlimited_square_table[pos-1], p);
-	
-	
-	if(max_harmonics > nearest)
-		sum += bandlimited_squarepart(nearest+1, max_harmonics, p);
-	else if(max_harmonics < nearest)
-		sum -= bandlimited_squarepart( max_harmonics%2 == 0 ? max_harmonics+1 : max_harmonics, nearest-1, p);
-	
-	return  sum;
-	
-}
-
-/*
- * This function generates a normalized square wave approximate to the maximum number
- * of harmonics at a certain phase.
- *
- * param unsigned int maxium number of generated harmonics
- * param t_float phase
- *
- * return t_float the calculated wave
- */
-static t_float bandlimited_square_aprox(unsigned int max_harmonics, t_float p, t_float dutycycle) {
-	
-	unsigned int pos = bandlimited_harmposfloor(max_harmonics);
-	
-
-	
-	t_float sum;
-	sum = bandlimited_read(bandlimited_square_table[pos-1], p);
-	
-	
-	return sum;
-	
-}
-
-
-
-/*
- * This function calculates the harmonic components for a triangle wave on
- * phase p from start to max_harmonics
- *
- * param unsigned int starting harmonic
- * param unsigned int stopping harmonic
- * param t_float phase
- *
- * return t_float the calculated wave component
- */
-static t_float bandlimited_trianglepart(unsigned int start, unsigned int max_harmonics, t_float p) {
-	unsigned int i;
-	double sum=0.0f;
-	
-	
-	for(i = start; i <= max_harmonics; i += 2) {
-		
-		//sum += (powf(-1.0f, (i-1)/2.0f) * bandlimited_sin(p * i))/powf(i, 2.0f) ;
-		sum += (bandlimited_sin(p * i)/powf(i, 2.0f)) * (i%4==3 ? -1 : 1 );
-		
-	}
-	
-	return  8.0f * sum /BANDLIMITED_PISQ;
-}
-
-/*
- * This function generates a normalized triangle wave with a maximum number
- * of harmonics at a certain phase.
- *
- * param unsigned int maxium number of generated harmonics
- * param t_float phase
- *
- * return t_float the calculated wave
- */
-static t_float bandlimited_triangle(unsigned int max_harmonics, t_float p, t_float dutycycle) {
-	unsigned int pos = bandlimited_harmpos(max_harmonics);
-	
-	unsigned int nearest = (pos) * BANDLIMITED_INCREMENT;
-	
-	double sum;
-	sum = bandlimited_read(bandlimited_triangle_table[pos-1], p);
-	
-	
-	if(max_harmonics > nearest)
-		sum += bandlimited_trianglepart  (nearest+1, max_harmonics, p);
-	else if(max_harmonics < nearest)
-		sum -= bandlimited_trianglepart( max_harmonics%2 == 0 ? max_harmonics+1 : max_harmonics, nearest-1, p);
-	
-	return sum;	
-	
-	
-}
-
-/*
- * This function generates a normalized triangle wave approximate to the maximum number
- * of harmonics at a certain phase.
- *
- * param unsigned int maxium number of generated harmonics
- * param t_float phase
- *
- * return t_float the calculated wave
- */
-static t_float bandlimited_triangle_aprox(unsigned int max_harmonics, t_float p, t_float dutycycle) {
-	unsigned int pos = bandlimited_harmposfloor(max_harmonics);
-	
-
-	
-	double sum;
-	sum = bandlimited_read(bandlimited_triangle_table[pos-1], p);
-	
-
-	
-	return sum;	
-	
-	
-}
-
-/*
- * This function calculates the harmonic components for a sawtooth wave on
- * phase p from start to max_harmonics
- *
- * param unsigned int starting harmonic
- * param unsigned int stopping harmonic
- * param t_float phase
- *
- * return t_float the calculated wave component
- */
-static inline t_float bandlimited_sawwavepart(unsigned int start, unsigned int max_harmonics, t_float p) {
-	unsigned int i;
-	double sum=0.0f;
-	
-	for(i = start; i <= max_harmonics; i++) {
-		
-		sum += bandlimited_sin(p * i)/i;
-	}
-	
-	return  2.0f * sum/BANDLIMITED_PI;
-}
-
-/*
- * This function generates a non normalized sawtooth wave with a maximum number
- * of harmonics at a certain phase.
- *
- * param unsigned int maxium number of generated harmonics
- * param t_float phase
- *
- * return t_float the calculated wave
- */
-static inline t_float bandlimited_sawwave(unsigned int max_harmonics, t_float p) {
-
-	unsigned int pos = bandlimited_harmpos(max_harmonics);
-	
-	unsigned int nearest = (pos) * BANDLIMITED_INCREMENT;
-	
-	double sum;
-	sum = bandlimited_read(bandlimited_sawwave_table[pos-1], p);
-	
-	
-	if(max_harmonics > nearest)
-		sum += bandlimited_sawwavepart  (nearest+1, max_harmonics, p);
-	else if(max_harmonics < nearest)
-		sum -= bandlimited_sawwavepart(max_harmonics, nearest-1, p);
-	
-	return  sum;	
-	
-	
-}
-
-/*
- * This function generates a normalized saw wave approximate to the maximum number
- * of harmonics at a certain phase.
- *
- * param unsigned int maxium number of generated harmonics
- * param t_float phase
- *
- * return t_float the calculated wave
- */
-static inline t_float bandlimited_sawwave_aprox(unsigned int max_harmonics, t_float p) {
-	
-	unsigned int pos = bandlimited_harmposfloor(max_harmonics);
-	
-
-	
-	double sum;
-	sum = bandlimited_read(bandlimited_sawwave_table[pos-1], p);
-	
-
-	
-	return  sum;	
-	
-	
-}
-
-/*
- * This function generates a normalized sawtooth wave with a maximum number
- * of harmonics at a certain phase.
- *
- * param unsigned int maxium number of generated harmonics
- * param t_float phase
- *
- * return t_float the calculated wave
- */
-static t_float bandlimited_saw(unsigned int max_harmonics, t_float p, t_float dutycycle) {
-	return -1.0f * bandlimited_sawwave(max_harmonics,  p);
-}
-
-/*
- * This function generates a normalized sawtooth wave with a maximum number
- * of harmonics at a certain phase.
- *
- * param unsigned int maxium number of generated harmonics
- * param t_float phase
- *
- * return t_float the calculated wave
- */
-static t_float bandlimited_saw_aprox(unsigned int max_harmonics, t_float p, t_float dutycycle) {
-	return -1.0f * bandlimited_sawwave_aprox(max_harmonics,  p);
-}
-
-/*
- * This function generates a normalized reverse sawtooth wave with a maximum number
- * of harmonics at a certain phase.
- *
- * param unsigned int maxium number of generated harmonics
- * param t_float phase
- *
- * return t_float the calculated wave
- */
-static t_float bandlimited_rsaw(unsigned int max_harmonics, t_float p, t_float dutycycle) {
-	return  bandlimited_sawwave(max_harmonics, p);
-}
-
-/*
- * This function generates a normalized reverse sawtooth wave with a maximum number
- * of harmonics at a certain phase.
- *
- * param unsigned int maxium number of generated harmonics
- * param t_float phase
- *
- * return t_float the calculated wave
- */
-static t_float bandlimited_rsaw_aprox(unsigned int max_harmonics, t_float p, t_float dutycycle) {
-	return  bandlimited_sawwave_aprox(max_harmonics, p);
-}
-
-
-/*
- * This function generates a normalized pulse wave with a maximum number
- * of harmonics at a certain phase.
- *
- * param unsigned int maxium number of generated harmonics
- * param t_float phase
- * param t_float dutycycle
- *
- * return t_float the calculated wave
- */
-static t_float bandlimited_pulse(unsigned int max_harmonics, t_float p, t_float dutycycle) {
-	return (bandlimited_saw(max_harmonics, p, dutycycle) - bandlimited_saw(max_harmonics, p + dutycycle, dutycycle)) -2.0f* (0.5f - dutycycle);
-}
-
-/*
- * This function generates a normalized pulse wave with a maximum number
- * of harmonics at a certain phase.
- *
- * param unsigned int maxium number of generated harmonics
- * param t_float phase
- * param t_float dutycycle
- *
- * return t_float the calculated wave
- */
-static t_float bandlimited_pulse_aprox(unsigned int max_harmonics, t_float p, t_float dutycycle) {
-	return (bandlimited_saw_aprox(max_harmonics, p, dutycycle) - bandlimited_saw_aprox(max_harmonics, p + dutycycle, dutycycle)) -2.0f* (0.5f - dutycycle);
-								   
-}
-
-
 /*
- * This function calculates the harmonic components for a sawtooth-triangle wave on
- * phase p from start to max_harmonics
- *
- * param unsigned int starting harmonic
- * param unsigned int stopping harmonic
- * param t_float phase
- *
- * return t_float the calculated wave component
- */
-static t_float bandlimited_sawtrianglepart(unsigned int start, unsigned int max_harmonics, t_float p) {
-	
-	unsigned int i;
-	double sumt=0.0f;
-	double sums=0.0f;
-	double sinc;
-	
-	
-	for(i = start; i <= max_harmonics; i ++) {
-		sinc = bandlimited_sin(p * i);
-		if(i%2 == 1)
-			sumt += (sinc/powf(i, 2.0f)) * (i%4==3 ? -1 : 1 );
-		sums += sinc/i;
-		
-	}
-	
-	return  2.0f * ((4.0f *  sumt / BANDLIMITED_PI) -  sums ) / BANDLIMITED_PI ;
-	
-}
-
-/*
- * This function generates a normalized sawtooth-triangle wave with a maximum number
- * of harmonics at a certain phase.
- *
- * param unsigned int maxium number of generated harmonics
- * param t_float phase
- *
- * return t_float the calculated wave
- */
-static t_float bandlimited_sawtriangle( unsigned int max_harmonics, t_float p, t_float dutycycle) {
-
-	unsigned int pos = bandlimited_harmpos(max_harmonics);
-	
-	unsigned int nearest = (pos) * BANDLIMITED_INCREMENT;
-	
-	t_float sum;
-	sum = bandlimited_read(bandlimited_sawtriangle_table[pos-1], p);
-	
-	
-	if(max_harmonics > nearest)
-		sum += bandlimited_sawtrianglepart(nearest+1, max_harmonics, p);
-	else if(max_harmonics < nearest)
-		sum -= bandlimited_sawtrianglepart(max_harmonics, nearest-1, p);
-	
-	return  sum;	
-	
-	
-}
-
-
-/*
- * This function generates a normalized saw-triangle wave approximate to the maximum number
- * of harmonics at a certain phase.
- *
- * param unsigned int maxium number of generated harmonics
- * param t_float phase
- *
- * return t_float the calculated wave
- */
-static t_float bandlimited_sawtriangle_aprox( unsigned int max_harmonics, t_float p, t_float dutycycle) {
-	
-	unsigned int pos = bandlimited_harmposfloor(max_harmonics);
-	
-
-	
-	t_float sum;
-	sum = bandlimited_read(bandlimited_sawtriangle_table[pos-1], p);
-
-	
-	return  sum;	
-	
-	
-}
-
-
-/*
- * This function generates the sin(2pi * x) wavetable.
- *
- */
-static void bandlimited_dmaketable(void)
-{
-    int i;
-    float *fp, phase, phsinc = (2.0f * BANDLIMITED_PI) / BANDLIMITED_TABSIZE;
-    union tabfudge tf;
-    
-    if (bandlimited_sin_table) return;
-    bandlimited_sin_table = (float *)getbytes(sizeof(float) * (BANDLIMITED_TABSIZE+3));
-    for (i = BANDLIMITED_TABSIZE+3, fp = (bandlimited_sin_table), phase = -phsinc; i--;
-		 fp++, phase += phsinc)
-		*fp = sin(phase);
-	
-	/* here we check at startup whether the byte alignment
-	 is as we declared it.  If not, the code has to be
-	 recompiled the other way. */
-    tf.tf_d = UNITBIT32 + 0.5;
-    if ((unsigned)tf.tf_i[LOWOFFSET] != 0x80000000)
-        bug("bandlimited~: unexpected machine alignment");
-	
+ * Pd 0.54 and up can patch several channels through one signal
+ * connection. Every channel of the frequency inlet is a voice with its own
+ * phase, cutoff and maximum, the rest of the object's settings are shared
+ * and all voices are rendered in one perform routine.
+ */
+#ifdef CLASS_MULTICHANNEL
+#define BANDLIMITED_CLASSFLAGS CLASS_MULTICHANNEL
+#else
+#define BANDLIMITED_CLASSFLAGS 0
+#endif
 
-}
 
 /*
- * This function is called when the last bandlimited~ object
- * is deleted. It clears up the meory used by all wavetables.
+ * This function is called when a bandlimited~ object is deleted.
+ * The last one clears up the memory used by all wavetables.
  *
  */
 static void bandlimited_delete(t_bandlimited *x) {
-	int i;
-	
-	if(--bandlimited_count == 0l) {
+	bandlimited_voices_free(&x->x_voices);
+	if(bandlimited_tables_free())
 		post("bandlimited~: deleting look up tables");
-		freebytes(bandlimited_sin_table, sizeof(float) * (BANDLIMITED_TABSIZE+3));
-		bandlimited_sin_table=0;
-		
-		
-		for(i =0; i < BANDLIMITED_HAMSIZE; i ++) {
-			freebytes(bandlimited_sawwave_table[i], sizeof(float) * (BANDLIMITED_TABSIZE+3));
-			freebytes(bandlimited_triangle_table[i], sizeof(float) * (BANDLIMITED_TABSIZE+3));
-			freebytes(bandlimited_square_table[i], sizeof(float) * (BANDLIMITED_TABSIZE+3));
-			freebytes(bandlimited_sawtriangle_table[i], sizeof(float) * (BANDLIMITED_TABSIZE+3));
-		}	  
-		freebytes(bandlimited_sawwave_table, sizeof(float *) * BANDLIMITED_HAMSIZE);
-		bandlimited_sawwave_table=0;
-		freebytes(bandlimited_triangle_table, sizeof(float *) * BANDLIMITED_HAMSIZE);
-		bandlimited_triangle_table=0;
-		freebytes(bandlimited_square_table, sizeof(float *) * BANDLIMITED_HAMSIZE);
-		bandlimited_square_table=0;
-		freebytes(bandlimited_sawtriangle_table, sizeof(float *) * BANDLIMITED_HAMSIZE);
-		bandlimited_sawtriangle_table=0;
-		
-		
-	}
-}
-
-/*
- * This function generates a waveform wavetable with a certain number
- * of harmonics
- *
- * param float** pointer to all wavetables of a certain waveform
- * param unsigned int position of the wavetable in the first parameter
- *						number of harmonics is this value plus 1 times BANDLIMITED_INCREMENT
- * param t_float *(unsigned int, unsigned int, t_float) pointer to waveform part function
- *
- */
-static void bandlimited_dmakewavetable(float **table, unsigned int pos, t_float (*part)(unsigned int, unsigned int, t_float))
-{
-    int i;
-    t_float *fp, phase, phsinc = (1.0f) / (BANDLIMITED_TABSIZE);
-    union tabfudge tf;
-	unsigned int max_harmonics =  (pos+1) * BANDLIMITED_INCREMENT;
-	unsigned int max_harmonics0;
-	t_float *previous = pos==0? 0: table[pos-1];
-
-	table[pos] = (float *)getbytes(sizeof(float) * (BANDLIMITED_TABSIZE+3));
-
-	
-    
-	if(previous) {
-
-		max_harmonics0 = max_harmonics-BANDLIMITED_INCREMENT+1;
-		for (i = BANDLIMITED_TABSIZE+3 , fp = (table[pos]), phase = -phsinc; i--;
-			 fp++, phase += phsinc,previous++) {
-			*fp = part(max_harmonics0,max_harmonics, phase) + *previous;
-		}
-	} else {
-		for (i = BANDLIMITED_TABSIZE+3 , fp = (table[pos]), phase = -phsinc; i--;
-			 fp++, phase += phsinc)
-			*fp = part(1,max_harmonics, phase);
-	}
-	
-	/* here we check at startup whether the byte alignment
-	 is as we declared it.  If not, the code has to be
-	 recompiled the other way. */
-    tf.tf_d = UNITBIT32 + 0.5;
-    if ((unsigned)tf.tf_i[LOWOFFSET] != 0x80000000)
-        bug("bandlimited~: unexpected machine alignment");
-	
-	
-
-
-	
 }
 
 /*
@@ -655,64 +81,55 @@ static void bandlimited_dmakewavetable(float **table, unsigned int pos, t_float
  * return int 0 on sucess, 1 on failute (invalid type)
  */
 static inline int bandlimited_typeset(t_bandlimited *x, t_symbol *type) {
+	t_bandlimited_wave wave;
+	
+	if(bandlimited_wave_parse(GETSTRING(type), &wave))
+		return 1;
 	x->type=type;
-	if(strcmp(GETSTRING(type), "saw") == 0) {
-		x->generator=  x->approximate ? &bandlimited_saw_aprox : &bandlimited_saw;
-	} else if(strcmp(GETSTRING(type), "rsaw") == 0) {
-		x->generator=  x->approximate ? &bandlimited_rsaw_aprox : &bandlimited_rsaw;
-	} else if(strcmp(GETSTRING(type), "square") == 0) {
-		x->generator=  x->approximate ? &bandlimited_square_aprox : &bandlimited_square;
-	} else if(strcmp(GETSTRING(type), "triangle") == 0) {
-		x->generator=  x->approximate ? &bandlimited_triangle_aprox : &bandlimited_triangle;
-	} else if(strcmp(GETSTRING(type), "sawtriangle") == 0) {
-		x->generator=  x->approximate ? &bandlimited_sawtriangle_aprox : &bandlimited_sawtriangle;
-	} else if(strcmp(GETSTRING(type), "pulse") == 0) {
-		x->generator=  x->approximate ? &bandlimited_pulse_aprox : &bandlimited_pulse;
-	} else {
-		goto type_unknown;
-		
-	}
+	bandlimited_osc_settype(&x->x_osc, wave);
 	return 0;
-type_unknown:
-	return 1;
 }
 
-static void bandlimited_dmakealltables(void) {
-	unsigned int i;
-	
-	post("bandlimited~: creating look up tables");
-	bandlimited_sin = &bandlimited_sin_real;
-   	bandlimited_dmaketable();
-	
-   	bandlimited_sawwave_table = (float **)getbytes(sizeof(float *) * BANDLIMITED_HAMSIZE);
-   	bandlimited_triangle_table = (float **)getbytes(sizeof(float *) * BANDLIMITED_HAMSIZE);
-   	bandlimited_square_table = (float **)getbytes(sizeof(float *) * BANDLIMITED_HAMSIZE);
-   	bandlimited_sawtriangle_table = (float **)getbytes(sizeof(float *) * BANDLIMITED_HAMSIZE);
-
-							   
-   	for(i =0; i < BANDLIMITED_HAMSIZE; i ++) {
-		bandlimited_dmakewavetable(bandlimited_sawwave_table,i, bandlimited_sawwavepart);
-
-		bandlimited_dmakewavetable(bandlimited_triangle_table,i,bandlimited_trianglepart);
-
-		bandlimited_dmakewavetable(bandlimited_square_table,i, bandlimited_squarepart);
-
-		bandlimited_dmakewavetable(bandlimited_sawtriangle_table,i, bandlimited_sawtrianglepart);
-
+/*
+ * This function posts how the table set the object has just moved onto
+ * was made, if it was, see bandlimited_osc_setsr.
+ *
+ * param t_bandlimited* pointer to the bandlimited~ object
+ * param int what bandlimited_osc_setsr, bandlimited_osc_setcutoff or
+ *			 bandlimited_osc_settabsize returned
+ */
+static void bandlimited_tablestatus(t_bandlimited *x, int status) {
+	const t_bandlimited_tableset *set = x->x_osc.set;
+
+	switch(status) {
+		case BANDLIMITED_TABLES_BUILT:
+			post("bandlimited~: creating %d point look up tables for %g hz for %s in the background", bandlimited_osc_tabsize(&x->x_osc),
+				 x->x_osc.sr, bandlimited_tableset_cachefile(set));
+			break;
+		case BANDLIMITED_TABLES_LOADED:
+			post("bandlimited~: loaded %d point look up tables for %g hz from %s in %.1f ms", bandlimited_osc_tabsize(&x->x_osc), x->x_osc.sr,
+				 bandlimited_tableset_cachefile(set), 1000 * bandlimited_tableset_time(set, 0));
+			break;
+		case BANDLIMITED_TABLES_LAZY:
+			post("bandlimited~: no look up table cache, creating %d point tables for %g hz as they are needed",
+				 bandlimited_osc_tabsize(&x->x_osc), x->x_osc.sr);
+			break;
+		case BANDLIMITED_TABLES_NOMEMORY:
+			error("bandlimited~: out of memory for the %d point look up tables for %g hz", bandlimited_osc_tabsize(&x->x_osc), x->x_osc.sr);
+			return;
 	}
-	bandlimited_sin = &bandlimited_sin_4point;
-	
+	if(status && bandlimited_tableset_levels(set) < BANDLIMITED_HAMSIZE)
+		post("bandlimited~: %u look up tables per waveform for %g hz", bandlimited_tableset_levels(set), x->x_osc.sr);
 }
 
-
 static void *bandlimited_new( t_symbol *s, int argc, t_atom *argv) {
 	t_bandlimited *x;// = (t_bandlimited *)pd_new(bandlimited_class);
 	t_float  f;
 	t_symbol *type;
 	t_float  max_harmonics;
 	t_float	cutoff;
-	int approximate;
-	
+	t_float approximate;
+
 	if(argc == 0) {
 		error("bandlimited~: missing first argument: type (saw, rsaw, square, triangle, pulse)");
 		goto new_error;
@@ -753,10 +170,10 @@ static void *bandlimited_new( t_symbol *s, int argc, t_atom *argv) {
 	}
 	if(argc > 4) {
 		if(!ISFLOAT(argv[4])) {
-			error("bandlimited~: forth argument must be a float: approximate waveform (default 0, off)");
+			error("bandlimited~: fifth argument must be a float: approximate waveform (default 0, off, 2 crossfades)");
 			goto new_error;
 		}
-		approximate = atom_getfloat(&argv[3]);
+		approximate = atom_getfloat(&argv[4]);
 	} else {
 		approximate=0;
 	}
@@ -764,21 +181,22 @@ static void *bandlimited_new( t_symbol *s, int argc, t_atom *argv) {
 	
     x = (t_bandlimited *)pd_new(bandlimited_class);
     
-    if(bandlimited_count++ == 0l) {
-		bandlimited_dmakealltables();
-		
-    }
+    // the tables themselves are made for the sample rate, see bandlimited_dsp
+    if(bandlimited_tables_new() && bandlimited_checkalignment())
+		bug("bandlimited~: unexpected machine alignment");
     
-	x->cutoff=cutoff;
     x->x_f = f;
-	x->s_nq=0;
-	x->max_harmonics=max_harmonics;
-	x->approximate=approximate;
+	bandlimited_osc_init(&x->x_osc, BANDLIMITED_SAW, max_harmonics, cutoff,
+						 approximate == 0 ? BANDLIMITED_EXACT : approximate == 2 ? BANDLIMITED_CROSSFADE : BANDLIMITED_APPROXIMATE);
+	if(bandlimited_voices_resize(&x->x_voices, 1, &x->x_osc)) {
+		error("bandlimited~: out of memory");
+		pd_free((t_pd *)x);
+		goto new_error;
+	}
+	x->type = gensym("saw");
 	if(bandlimited_typeset(x, type) == 1) {
 		error("bandlimited~: Uknown type %s, using saw", GETSTRING(type));
-		x->generator=  &bandlimited_saw;
 	}
-    x->x_phase = 0;
 
 	
 	
@@ -796,81 +214,130 @@ new_error:
 
 static void bandlimited_ft1(t_bandlimited *x, t_float f)
 {
-    x->x_phase =   f;
+	bandlimited_osc_setphase(&x->x_osc, f);
+	bandlimited_voices_setphase(&x->x_voices, &x->x_osc, f);
+}
+
+/*
+ * This function sets unison: unison voices detune spread, see
+ * bandlimited_osc_setunison.
+ *
+ */
+static void bandlimited_unison(t_bandlimited *x, t_float voices, t_float detune, t_float spread)
+{
+	if(voices > BANDLIMITED_MAXUNISON)
+		post("bandlimited~: at most %d unison voices, using %d", BANDLIMITED_MAXUNISON, BANDLIMITED_MAXUNISON);
+	bandlimited_osc_setunison(&x->x_osc, (int)voices, detune, spread);
+}
+
+/*
+ * This function sets the cutoff: one value for every voice, or a list with
+ * a value per voice, voices past the list keep theirs. The object's own
+ * cutoff is the highest, it picks the look up tables every voice reads.
+ *
+ * param t_bandlimited* pointer to the bandlimited~ object
+ * param t_symbol * selector
+ * param int number of values
+ * param t_atom * cutoffs in hz
+ */
+static void bandlimited_cutoff(t_bandlimited *x, t_symbol *s, int argc, t_atom *argv)
+{
+	t_bandlimited_voices *v = &x->x_voices;
+	float f, top = 0;
+	int i;
+
+	for(i = 0; i < v->n && i < (argc > 1 ? argc : v->n); i++) {
+		f = atom_getfloatarg(argc > 1 ? i : 0, argc, argv);
+		if(x->x_osc.s_nq != 0 && f > x->x_osc.s_nq) {
+			error("bandlimited~: %f is greater than the nyquist limit %f, ignoring", f, x->x_osc.s_nq);
+			continue;
+		}
+		v->cutoff[i] = f < 1 ? x->x_osc.s_nq-1 : f;
+	}
+	for(i = 0; i < v->n; i++) {
+		if(v->cutoff[i] <= 0)
+			top = x->x_osc.s_nq;
+		else if(v->cutoff[i] > top)
+			top = v->cutoff[i];
+	}
+	bandlimited_tablestatus(x, bandlimited_osc_setcutoff(&x->x_osc, top == x->x_osc.s_nq ? 0 : top));
 }
 
-static void bandlimited_cutoff(t_bandlimited *x, t_float f)
+static void bandlimited_tablesize(t_bandlimited *x, t_float f)
 {
-	if(x->s_nq != 0 && f > x->s_nq) 
-		error("bandlimited~: %f is greater than the nyquist limit %f, ignoring", f, x->s_nq);
-	else if(f < 1 )
-		x->cutoff = x->s_nq-1;
-	else 
-		x->cutoff = f;
+	int size = (int)f, status;
+
+	status = bandlimited_osc_settabsize(&x->x_osc, size);
+	if(size > 0 && size != bandlimited_osc_tabsize(&x->x_osc))
+		post("bandlimited~: tables of 512, 1024, 2048 or 4096 points, using %d", bandlimited_osc_tabsize(&x->x_osc));
+	bandlimited_tablestatus(x, status);
 }
 
 
 
-static void bandlimited_max(t_bandlimited *x, t_float f)
+/*
+ * This function sets the maximum number of harmonics, for every voice or
+ * a voice per value of a list like bandlimited_cutoff.
+ *
+ * param t_bandlimited* pointer to the bandlimited~ object
+ * param t_symbol * selector
+ * param int number of values
+ * param t_atom * maximum numbers of harmonics
+ */
+static void bandlimited_max(t_bandlimited *x, t_symbol *s, int argc, t_atom *argv)
 {
-	int val = (int)f;
-	if(val < 1) {
-		val = BANDLIMITED_MAXHARMONICS;
+	t_bandlimited_voices *v = &x->x_voices;
+	int i, val;
+
+	for(i = 0; i < v->n && i < (argc > 1 ? argc : v->n); i++) {
+		val = (int)atom_getfloatarg(argc > 1 ? i : 0, argc, argv);
+		if(val < 1) {
+			val = BANDLIMITED_MAXHARMONICS;
+		}
+		else if(val > BANDLIMITED_MAXHARMONICS && (argc > 1 || i == 0))
+			post("bandlimited~: maximum number of harmonics %d might be too high. you are warned", val);
+		v->max_harmonics[i] = val;
 	}
-	else if(val > BANDLIMITED_MAXHARMONICS) 
-		post("bandlimited~: maximum number of harmonics %d might be too high. you are warned", val);
-	x->max_harmonics = val;
-	
+	if(argc <= 1 && v->n)
+		x->x_osc.max_harmonics = v->max_harmonics[0];
 }
 
 static void bandlimited_approximate(t_bandlimited *x, t_float f)
 {
-	int last = x->approximate;
-	x->approximate = f? 1: 0;
-	if(x->approximate != last)
-		bandlimited_typeset(x,x->type); 
+	bandlimited_osc_setmode(&x->x_osc, f? BANDLIMITED_APPROXIMATE: BANDLIMITED_EXACT);
+
+	
+}
+
+static void bandlimited_crossfade(t_bandlimited *x, t_float f)
+{
+	bandlimited_osc_setmode(&x->x_osc, f? BANDLIMITED_CROSSFADE: BANDLIMITED_EXACT);
 
 	
 }
 
 #ifdef DEBUG
 static void bandlimited_testsine(t_bandlimited *x, t_float f) {
-	post("bandlimited~: linear sin(2pi %f) = %f", f, bandlimited_sin_lin(f));
-	post("bandlimited~: 4point sin(2pi %f) = %f", f, bandlimited_sin(f));
+	post("bandlimited~: linear sin(2pi %f) = %f", f, bandlimited_testsin_lin(f));
+	post("bandlimited~: 4point sin(2pi %f) = %f", f, bandlimited_testsin(f));
 	post("bandlimited~:   real sin(2pi %f) = %f",  f, sin(2.0*BANDLIMITED_PI*f));
 }
 
 static void bandlimited_print(t_bandlimited *x, t_float freq) {
-	unsigned int max_harmonics = (unsigned int)( x->cutoff / freq);
-	unsigned int pos;
-	unsigned int nearest;
+	unsigned int max_harmonics = (unsigned int)( x->x_osc.cutoff / freq);
 	unsigned int i;
-	t_float (*generator)(unsigned int, unsigned int, t_float)=0;
+	float harmonic;
 	
 
 	
-	if(max_harmonics > x->max_harmonics)
-		max_harmonics = x->max_harmonics;
+	if(max_harmonics > x->x_osc.max_harmonics)
+		max_harmonics = x->x_osc.max_harmonics;
 	
-	pos = bandlimited_harmpos(max_harmonics);
-	nearest = pos-- * BANDLIMITED_INCREMENT;
-	post("bandlimited~: nearest harmonics is %d of %d", nearest,max_harmonics);
-	if(x->generator == &bandlimited_saw || x->generator == &bandlimited_rsaw) {
-		generator = &bandlimited_sawwavepart;
-	} else if(x->generator == &bandlimited_square) {
-		generator = &bandlimited_squarepart;
-	} else if(x->generator == &bandlimited_triangle) {
-		generator = &bandlimited_trianglepart;
-	} else if(x->generator == &bandlimited_sawtriangle) {
-		generator = &bandlimited_sawtrianglepart;
-	} else if(x->generator == &bandlimited_pulse) {
-		generator = &bandlimited_sawwavepart;
-	}
-	
-	if(generator) {
-		for(i = 1; i <= max_harmonics; i++) {
-			post("bandlimited~: %d\t%f", i, generator(i, i, 0.25f));
-		}
+	post("bandlimited~: nearest harmonics is %d of %d", bandlimited_nearest(&x->x_osc, max_harmonics),max_harmonics);
+	for(i = 1; i <= max_harmonics; i++) {
+		if(bandlimited_harmonic(&x->x_osc, i, 0.25f, &harmonic))
+			break;
+		post("bandlimited~: %d\t%f", i, harmonic);
 	}
 
 	
@@ -878,6 +345,60 @@ static void bandlimited_print(t_bandlimited *x, t_float freq) {
 #endif
 
 
+/*
+ * This function is the stats method: it prints what the object has done
+ * since it was created or its stats were reset, and what the shared
+ * wavetables take. stats reset zeroes the object's counters.
+ *
+ * param t_bandlimited* pointer to the bandlimited~ object
+ * param t_symbol * reset, or empty to print
+ */
+static void bandlimited_stats(t_bandlimited *x, t_symbol *s)
+{
+	static const char *modes[] = {"exact", "approximate", "crossfade"};
+	static const char *buckets[] = {"0", "1", "2-3", "4-7", "8-15", "16-31", "32-63", "64+"};
+	const t_bandlimited_stats *st = &x->x_osc.stats;
+	const t_bandlimited_tableset *set = x->x_osc.set;
+	unsigned int levels, low = 0, high = 0, tables, lazy;
+	double picks = st->picks ? (double)st->picks : 1.0, rt;
+	char line[256];
+	int b, len, threads;
+	size_t bytes;
+	
+	if(s == gensym("reset")) {
+		bandlimited_osc_resetstats(&x->x_osc);
+		x->x_time = 0;
+		x->x_performed = 0;
+		return;
+	}
+	rt = x->x_osc.sr > 0 ? x->x_performed / x->x_osc.sr : 0.0;
+	post("bandlimited~: %s %s, %d voice(s) of %d unison", GETSTRING(x->type), modes[x->x_osc.mode], x->x_voices.n, x->x_osc.unison);
+	if(x->x_osc.kernelmode != x->x_osc.mode)
+		post("  read as %s, the look up tables for %g hz already cover the audible band", modes[x->x_osc.kernelmode], x->x_osc.sr);
+	post("  %llu samples in %.2f ms, %.1f ns/sample, %.2f%% of real time", (unsigned long long)st->samples, 1000 * x->x_time,
+		 st->samples ? 1e9 * x->x_time / st->samples : 0.0, rt > 0 ? 100 * x->x_time / rt : 0.0);
+	post("  %.2f%% of the samples past the wavetables", 100 * st->above / picks);
+	levels = bandlimited_stats_levels(&x->x_osc, &low, &high);
+	post("  %u of %u wavetable levels read, %u to %u harmonics", levels, set ? bandlimited_tableset_levels(set) : 0, low, high);
+	if(x->x_osc.kernelmode == BANDLIMITED_EXACT) {
+		len = snprintf(line, sizeof(line), "  exact correction harmonics:");
+		for(b = 0; b < BANDLIMITED_STATSBUCKETS; b++)
+			len += snprintf(line + len, sizeof(line) - len, " %s %.1f%%", buckets[b], 100 * st->residual[b] / picks);
+		post("%s", line);
+	}
+	bytes = bandlimited_tables_bytes(&tables);
+	post("bandlimited~: %u look up tables in %.1f kB", tables, bytes / 1024.0);
+	if(set) {
+		bandlimited_tableset_time(set, &threads);
+		post("  the %d point ones for %g hz %s in %.1f ms%s", bandlimited_osc_tabsize(&x->x_osc), x->x_osc.sr,
+			 threads ? "built" : bandlimited_tableset_cachefile(set)[0] ? "loaded" : "set up",
+			 1000 * bandlimited_tableset_time(set, 0), bandlimited_tableset_hugepages(set) ? ", on huge pages" : "");
+	}
+	if(bandlimited_tables_lazytime(&lazy) > 0 || lazy)
+		post("  %u built as they were needed in %.1f ms", lazy, 1000 * bandlimited_tables_lazytime(0));
+}
+
+
 /*
  * This function is the set method.
  *
@@ -907,52 +428,12 @@ static t_int *bandlimited_perform(t_int *w) {
     t_float *dutycycle = (t_float *)(w[3]);
     t_float *out = (t_float *)(w[4]);
     int n = (int)(w[5]);
-	t_signal *sp = (t_signal *)(w[6]);
-	t_float p;
-    double dphase = x->x_phase + UNITBIT32;
-    union tabfudge tf;
-    int normhipart;
-	unsigned int max_harmonics;
-	t_float cutoff;
-	float conv;
+    int dcvoices = (int)(w[6]);
+	double start = bandlimited_clock();
 	
-	conv = 1.0f/sp->s_sr;
-	x->s_nq = sp->s_sr / 2.0f - 1;
-	cutoff = x->cutoff == 0? x->s_nq : x->cutoff;
-
-
-
-	
-
-	tf.tf_d = UNITBIT32;
-    normhipart = tf.tf_i[HIOFFSET];
-    tf.tf_d = dphase;
-	
-    while (n--)
-    {
-		
-		if( *in > 0.0) {
-			tf.tf_i[HIOFFSET] = normhipart;
-			dphase += *in * conv;
-			p = tf.tf_d - UNITBIT32;
-			tf.tf_d = dphase;
-			
-			max_harmonics = (int)fmin((int)( cutoff / *in++), x->max_harmonics);
-			//max_harmonics = (int)( x->cutoff / *in++);
-			//if(max_harmonics > x->max_harmonics)
-			//	max_harmonics = x->max_harmonics;
-		
-
-			*out++ =  x->generator(max_harmonics, p, *dutycycle++);
-		} else {
-			*out++ = 0.0f;
-			in++;
-			dutycycle++;
-			tf.tf_d=0.0;
-		}
-    }
-    tf.tf_i[HIOFFSET] = normhipart;
-    x->x_phase = tf.tf_d - UNITBIT32;	
+	bandlimited_osc_rendervoices(&x->x_osc, &x->x_voices, in, dutycycle, dcvoices, out, n);
+	x->x_time += bandlimited_clock() - start;
+	x->x_performed += n;
 	
     return (w+7);	
 }
@@ -966,9 +447,21 @@ static t_int *bandlimited_perform(t_int *w) {
  */
 static void bandlimited_dsp(t_bandlimited *x, t_signal **sp)
 {
-
-    
-	dsp_add(bandlimited_perform, 6, x, sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[0]->s_n, sp[0]);
+	int voices = 1, dcvoices = 1;
+	
+#ifdef CLASS_MULTICHANNEL
+	voices = sp[0]->s_nchans;
+	dcvoices = sp[1]->s_nchans;
+	signal_setmultiout(&sp[2], voices);
+#endif
+	// voices that are kept keep their state, new ones start at phase 0
+	if(voices != x->x_voices.n && bandlimited_voices_resize(&x->x_voices, voices, &x->x_osc)) {
+		error("bandlimited~: out of memory for %d voices", voices);
+		dsp_add_zero(sp[2]->s_vec, voices * sp[0]->s_n);
+		return;
+	}
+    bandlimited_tablestatus(x, bandlimited_osc_setsr(&x->x_osc, sp[0]->s_sr));
+	dsp_add(bandlimited_perform, 6, x, sp[0]->s_vec, sp[1]->s_vec, sp[2]->s_vec, sp[0]->s_n, dcvoices);
 }
 
 
@@ -980,7 +473,7 @@ static void bandlimited_dsp(t_bandlimited *x, t_signal **sp)
 extern void bandlimited_tilde_setup(void)
 {
     bandlimited_class = class_new(gensym("bandlimited~"), (t_newmethod)bandlimited_new, (t_method) bandlimited_delete,
-								  sizeof(t_bandlimited), 0, A_GIMME, 0); //A_DEFSYMBOL, A_DEFFLOAT, A_DEFFLOAT, A_DEFFLOAT, A_DEFFLOAT
+								  sizeof(t_bandlimited), BANDLIMITED_CLASSFLAGS, A_GIMME, 0); //A_DEFSYMBOL, A_DEFFLOAT, A_DEFFLOAT, A_DEFFLOAT, A_DEFFLOAT
     CLASS_MAINSIGNALIN(bandlimited_class, t_bandlimited, x_f);
     class_addmethod(bandlimited_class, (t_method)bandlimited_dsp, gensym("dsp"), 0);
     class_addmethod(bandlimited_class, (t_method)bandlimited_ft1,
@@ -988,11 +481,19 @@ extern void bandlimited_tilde_setup(void)
     class_addmethod(bandlimited_class, (t_method)bandlimited_type,
 					gensym("type"), A_SYMBOL, 0);	
     class_addmethod(bandlimited_class, (t_method)bandlimited_cutoff,
-					gensym("cutoff"), A_FLOAT, 0);		
+					gensym("cutoff"), A_GIMME, 0);		
+    class_addmethod(bandlimited_class, (t_method)bandlimited_tablesize,
+					gensym("tablesize"), A_FLOAT, 0);		
     class_addmethod(bandlimited_class, (t_method)bandlimited_max,
-					gensym("max"), A_FLOAT, 0);		
+					gensym("max"), A_GIMME, 0);		
     class_addmethod(bandlimited_class, (t_method)bandlimited_approximate,
 					gensym("approximate"), A_FLOAT, 0);		
+    class_addmethod(bandlimited_class, (t_method)bandlimited_crossfade,
+					gensym("crossfade"), A_FLOAT, 0);		
+    class_addmethod(bandlimited_class, (t_method)bandlimited_unison,
+					gensym("unison"), A_FLOAT, A_DEFFLOAT, A_DEFFLOAT, 0);		
+    class_addmethod(bandlimited_class, (t_method)bandlimited_stats,
+					gensym("stats"), A_DEFSYMBOL, 0);		
 	
     debug(class_addmethod(bandlimited_class, (t_method)bandlimited_testsine,
 					gensym("testsine"), A_FLOAT, 0);)		